@@ -0,0 +1,448 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <list>
+
+#include "lib/FastMath.h"
+
+#define CALIBRATION_STANDARDS     4
+#define CALIBRATION_MAX_GRIDS     16
+#define CALIBRATION_FILE_HEADER   "litevnaserver-calibration"
+#define CALIBRATION_FILE_VERSION  1
+
+namespace litevnaserver {
+    // Correction of the values of a sweep
+    enum class SweepCalibration {
+        // Calibration stored in the device (LITEVNA_SAMPLES_MODE_DEVICE_CALIBRATION)
+        Device,
+        // Raw values (LITEVNA_SAMPLES_MODE_APP_CALIBRATION) corrected with the host calibration
+        Host,
+        // Raw values, not corrected
+        Raw
+    };
+
+    enum class CalibrationStandard {
+        Short,
+        Open,
+        Load,
+        Thru
+    };
+
+    // Complex values split in real and imaginary arrays, loaded directly into SIMD registers
+    struct ComplexArray {
+        vector<float> re;
+        vector<float> im;
+
+        void resize(size_t size) {
+            re.resize(size);
+            im.resize(size);
+        }
+
+        complex<float> get(size_t n) const {
+            return complex<float>(re[n], im[n]);
+        }
+
+        void set(size_t n, complex<double> value) {
+            re[n] = (float)value.real();
+            im[n] = (float)value.imag();
+        }
+    };
+
+    // Error terms of a one path two port SOLT calibration (what S11 and S21 measurements allow) on a
+    // frequency grid: directivity e00, source match e11 and reflection tracking e10e01 of port 1,
+    // isolation e30 and transmission tracking e10e32 (stored inverted) from port 1 to port 2.
+    struct ErrorTerms {
+        uint64_t start = 0;
+        uint64_t step = 0;
+        uint32_t points = 0;
+
+        ComplexArray directivity;
+        ComplexArray sourceMatch;
+        ComplexArray reflectionTracking;
+        ComplexArray isolation;
+        ComplexArray transmissionInverse;
+
+        void resize(uint32_t _points) {
+            points = _points;
+            directivity.resize(points);
+            sourceMatch.resize(points);
+            reflectionTracking.resize(points);
+            isolation.resize(points);
+            transmissionInverse.resize(points);
+        }
+    };
+
+    // Host calibration, one per device since each has its own errors. The short, open, load and thru
+    // standards are captured as raw sweeps of the same frequency grid, then the error terms are computed
+    // for that grid (and saved to `Config::calibrationFile`, numbered when there are several devices).
+    // Sweeps of other grids inside its range get the terms linearly interpolated, cached for the last
+    // CALIBRATION_MAX_GRIDS grids. Used only from the event loop thread, except `apply`.
+    class Calibration {
+    public:
+        // 1. Lifecycle
+        Calibration() = default;
+        Calibration(const Calibration&) = delete;
+        Calibration& operator=(const Calibration&) = delete;
+        Calibration(const Calibration&&) = delete;
+        Calibration& operator=(const Calibration&&) = delete;
+        ~Calibration() = default;
+
+        // Loads the saved calibration of every device, if any
+        Result initialize() {
+            devices.resize(config->comPorts.size());
+
+            if (config->calibrationFile.size() == 0) {
+                return Result::ok();
+            }
+            for (size_t device = 0; device < devices.size(); device++) {
+                string fileName = calibrationFileName(device);
+                FILE* file = fopen(fileName.data(), "rb");
+
+                if (file == nullptr) {
+                    LOGGER(Info, "No host calibration in {}", fileName);
+                    continue;
+                }
+                Result result = load(file, device);
+                fclose(file);
+
+                if (result) {
+                    return result;
+                }
+                const ErrorTerms& terms = *devices[device].terms;
+
+                LOGGER(Info, "Host calibration loaded from {}: start={}, step={}, points={}", fileName, terms.start, terms.step, terms.points);
+            }
+            return Result::ok();
+        }
+
+        // 2. Dependency injection
+        void setConfig(Config* _config) {
+            config = _config;
+        }
+
+        // 3. Functionalities
+        bool isComplete(size_t device) const {
+            return devices[device].terms != nullptr;
+        }
+
+        // Error terms on the calibration grid, or nullptr
+        shared_ptr<const ErrorTerms> getTerms(size_t device) const {
+            return devices[device].terms;
+        }
+
+        // Changes every time new error terms are computed or loaded, unique across devices
+        uint64_t getVersion(size_t device) const {
+            return devices[device].version;
+        }
+
+        bool isCaptured(size_t device, CalibrationStandard standard) const {
+            return devices[device].standards[(size_t)standard].captured;
+        }
+
+        static const char* toString(CalibrationStandard standard) {
+            static const char* names[CALIBRATION_STANDARDS] = { "short", "open", "load", "thru" };
+
+            return names[(size_t)standard];
+        }
+
+        // Stores the raw sweep of `standard`. A grid different from the one of the standards already
+        // captured starts a new calibration. Error terms are computed once every standard is captured.
+        Result capture(size_t device, CalibrationStandard standard, uint64_t start, uint64_t step, uint32_t points, const ScanValues& values) {
+            DeviceCalibration& calibration = devices[device];
+
+            if (start != calibration.gridStart || step != calibration.gridStep || points != calibration.gridPoints) {
+                for (Measurement& measurement : calibration.standards) {
+                    measurement.captured = false;
+                }
+                calibration.gridStart = start;
+                calibration.gridStep = step;
+                calibration.gridPoints = points;
+            }
+            Measurement& measurement = calibration.standards[(size_t)standard];
+            measurement.captured = true;
+            measurement.s11 = values.channel0In;
+            measurement.s21 = values.channel1In;
+
+            for (const Measurement& other : calibration.standards) {
+                if (!other.captured) {
+                    return Result::ok();
+                }
+            }
+            compute(device);
+
+            LOGGER(Info, "Host calibration of device {} computed: start={}, step={}, points={}", device, start, step, points);
+
+            return save(device);
+        }
+
+        // Error terms of the grid, nullptr if the calibration does not cover every frequency
+        shared_ptr<const ErrorTerms> getTerms(size_t device, uint64_t start, uint64_t step, uint32_t points) {
+            DeviceCalibration& calibration = devices[device];
+            list<shared_ptr<const ErrorTerms>>& grids = calibration.grids;
+
+            if (!calibration.terms) {
+                return nullptr;
+            }
+            for (auto it = grids.begin(); it != grids.end(); it++) {
+                if ((*it)->start == start && (*it)->step == step && (*it)->points == points) {
+                    grids.splice(grids.begin(), grids, it);
+                    return grids.front();
+                }
+            }
+            const ErrorTerms& terms = *calibration.terms;
+            uint64_t end = start + (uint64_t)(points - 1) * step;
+
+            if (start < terms.start || end > terms.start + (uint64_t)(terms.points - 1) * terms.step) {
+                return nullptr;
+            }
+            if (grids.size() >= CALIBRATION_MAX_GRIDS) {
+                grids.pop_back();
+            }
+            grids.push_front(interpolate(terms, start, step, points));
+
+            return grids.front();
+        }
+
+        // Corrects points [begin, end) of a raw sweep in place, 4 points at a time with SSE2:
+        //   s11 = (m11 - e00) / (e11 (m11 - e00) + e10e01)
+        //   s21 = (m21 - e30) (1 - e11 s11) / e10e32
+        static void apply(const ErrorTerms& terms, ScanValues& values, size_t begin, size_t end) {
+            complex<float>* s11 = values.channel0In.data();
+            complex<float>* s21 = values.channel1In.data();
+            size_t n = begin;
+
+#ifdef FAST_MATH_SSE2
+            for (; n + 4 <= end; n += 4) {
+                __m128 mRe;
+                __m128 mIm;
+                __m128 tRe;
+                __m128 tIm;
+                load4(s11 + n, mRe, mIm);
+                load4(s21 + n, tRe, tIm);
+
+                __m128 e11Re = _mm_loadu_ps(terms.sourceMatch.re.data() + n);
+                __m128 e11Im = _mm_loadu_ps(terms.sourceMatch.im.data() + n);
+                __m128 dRe = _mm_sub_ps(mRe, _mm_loadu_ps(terms.directivity.re.data() + n));
+                __m128 dIm = _mm_sub_ps(mIm, _mm_loadu_ps(terms.directivity.im.data() + n));
+
+                __m128 denRe;
+                __m128 denIm;
+                multiply(e11Re, e11Im, dRe, dIm, denRe, denIm);
+                denRe = _mm_add_ps(denRe, _mm_loadu_ps(terms.reflectionTracking.re.data() + n));
+                denIm = _mm_add_ps(denIm, _mm_loadu_ps(terms.reflectionTracking.im.data() + n));
+
+                // d / den = d * conj(den) / |den|^2
+                __m128 norm = _mm_add_ps(_mm_mul_ps(denRe, denRe), _mm_mul_ps(denIm, denIm));
+                __m128 gRe;
+                __m128 gIm;
+                multiply(dRe, dIm, denRe, _mm_sub_ps(_mm_setzero_ps(), denIm), gRe, gIm);
+                gRe = _mm_div_ps(gRe, norm);
+                gIm = _mm_div_ps(gIm, norm);
+
+                __m128 mismatchRe;
+                __m128 mismatchIm;
+                multiply(e11Re, e11Im, gRe, gIm, mismatchRe, mismatchIm);
+                mismatchRe = _mm_sub_ps(_mm_set1_ps(1.0f), mismatchRe);
+                mismatchIm = _mm_sub_ps(_mm_setzero_ps(), mismatchIm);
+
+                tRe = _mm_sub_ps(tRe, _mm_loadu_ps(terms.isolation.re.data() + n));
+                tIm = _mm_sub_ps(tIm, _mm_loadu_ps(terms.isolation.im.data() + n));
+                multiply(tRe, tIm, mismatchRe, mismatchIm, tRe, tIm);
+                multiply(tRe, tIm, _mm_loadu_ps(terms.transmissionInverse.re.data() + n), _mm_loadu_ps(terms.transmissionInverse.im.data() + n), tRe, tIm);
+
+                store4(s11 + n, gRe, gIm);
+                store4(s21 + n, tRe, tIm);
+            }
+#endif
+            for (; n < end; n++) {
+                complex<float> e11 = terms.sourceMatch.get(n);
+                complex<float> d = s11[n] - terms.directivity.get(n);
+                complex<float> den = e11 * d + terms.reflectionTracking.get(n);
+                complex<float> gamma = d * conj(den) / (den.real() * den.real() + den.imag() * den.imag());
+
+                s21[n] = (s21[n] - terms.isolation.get(n)) * (1.0f - e11 * gamma) * terms.transmissionInverse.get(n);
+                s11[n] = gamma;
+            }
+        }
+
+    private:
+        struct Measurement {
+            bool captured = false;
+            vector<complex<float>> s11;
+            vector<complex<float>> s21;
+        };
+
+        struct DeviceCalibration {
+            Measurement standards[CALIBRATION_STANDARDS];
+            uint64_t gridStart = 0;
+            uint64_t gridStep = 0;
+            uint32_t gridPoints = 0;
+
+            shared_ptr<ErrorTerms> terms;
+            uint64_t version = 0;
+            // Interpolated terms, most recently used first
+            list<shared_ptr<const ErrorTerms>> grids;
+        };
+
+        Config* config = nullptr;
+        // By device index
+        vector<DeviceCalibration> devices;
+        uint64_t lastVersion = 0;
+
+        // Ideal standards: short -1, open 1, load 0 and a matched thru
+        void compute(size_t device) {
+            const Measurement* standards = devices[device].standards;
+            uint32_t points = devices[device].gridPoints;
+            shared_ptr<ErrorTerms> computed = make_shared<ErrorTerms>();
+            computed->start = devices[device].gridStart;
+            computed->step = devices[device].gridStep;
+            computed->resize(points);
+
+            for (size_t n = 0; n < points; n++) {
+                complex<double> load = standards[(size_t)CalibrationStandard::Load].s11[n];
+                complex<double> a = complex<double>(standards[(size_t)CalibrationStandard::Open].s11[n]) - load;
+                complex<double> b = complex<double>(standards[(size_t)CalibrationStandard::Short].s11[n]) - load;
+                complex<double> e00 = load;
+                complex<double> e11 = (a + b) / (a - b);
+                complex<double> e10e01 = -2.0 * a * b / (a - b);
+                complex<double> e30 = standards[(size_t)CalibrationStandard::Load].s21[n];
+
+                // Port 2 match, seen through the thru
+                complex<double> thru = complex<double>(standards[(size_t)CalibrationStandard::Thru].s11[n]) - e00;
+                complex<double> e22 = thru / (e11 * thru + e10e01);
+                complex<double> e10e32 = (complex<double>(standards[(size_t)CalibrationStandard::Thru].s21[n]) - e30) * (1.0 - e11 * e22);
+
+                computed->directivity.set(n, e00);
+                computed->sourceMatch.set(n, e11);
+                computed->reflectionTracking.set(n, e10e01);
+                computed->isolation.set(n, e30);
+                computed->transmissionInverse.set(n, 1.0 / e10e32);
+            }
+            setTerms(device, computed);
+        }
+
+        void setTerms(size_t device, shared_ptr<ErrorTerms> terms) {
+            devices[device].terms = terms;
+            devices[device].version = ++lastVersion;
+            devices[device].grids.clear();
+        }
+
+        // One file per device, numbered when there are several
+        string calibrationFileName(size_t device) const {
+            return devices.size() > 1 ? su::format("{}.{}", config->calibrationFile, device) : config->calibrationFile;
+        }
+
+        static shared_ptr<ErrorTerms> interpolate(const ErrorTerms& from, uint64_t start, uint64_t step, uint32_t points) {
+            shared_ptr<ErrorTerms> to = make_shared<ErrorTerms>();
+            to->start = start;
+            to->step = step;
+            to->resize(points);
+
+            const ComplexArray* fromArrays[] = { &from.directivity, &from.sourceMatch, &from.reflectionTracking, &from.isolation, &from.transmissionInverse };
+            ComplexArray* toArrays[] = { &to->directivity, &to->sourceMatch, &to->reflectionTracking, &to->isolation, &to->transmissionInverse };
+
+            for (size_t n = 0; n < points; n++) {
+                uint64_t offset = start + n * step - from.start;
+                size_t index = (size_t)(offset / from.step);
+                float fraction = (float)(offset % from.step) / (float)from.step;
+
+                if (index + 1 >= from.points) {
+                    index = from.points - 1;
+                    fraction = 0.0f;
+                }
+                for (size_t k = 0; k < 5; k++) {
+                    const ComplexArray& a = *fromArrays[k];
+                    size_t next = fraction > 0.0f ? index + 1 : index;
+
+                    toArrays[k]->re[n] = a.re[index] + (a.re[next] - a.re[index]) * fraction;
+                    toArrays[k]->im[n] = a.im[index] + (a.im[next] - a.im[index]) * fraction;
+                }
+            }
+            return to;
+        }
+
+        // Text file: header and version, start step points, then one line per point with the real and
+        // imaginary parts of e00, e11, e10e01, e30 and 1/e10e32
+        Result save(size_t device) {
+            if (config->calibrationFile.size() == 0) {
+                return Result::ok();
+            }
+            string fileName = calibrationFileName(device);
+            FILE* file = fopen(fileName.data(), "wb");
+
+            if (file == nullptr) {
+                return Result("calibration_error", "Error creating calibration file `{}`: errno={} ({})", fileName, errno, strerror(errno));
+            }
+            const ErrorTerms& terms = *devices[device].terms;
+
+            fprintf(file, "%s %d\n%llu %llu %u\n", CALIBRATION_FILE_HEADER, CALIBRATION_FILE_VERSION,
+                (unsigned long long)terms.start, (unsigned long long)terms.step, terms.points);
+
+            for (size_t n = 0; n < terms.points; n++) {
+                fprintf(file, "%.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g %.9g\n",
+                    terms.directivity.re[n], terms.directivity.im[n], terms.sourceMatch.re[n], terms.sourceMatch.im[n],
+                    terms.reflectionTracking.re[n], terms.reflectionTracking.im[n], terms.isolation.re[n], terms.isolation.im[n],
+                    terms.transmissionInverse.re[n], terms.transmissionInverse.im[n]);
+            }
+            if (fclose(file) != 0) {
+                return Result("calibration_error", "Error writing calibration file `{}`: errno={} ({})", fileName, errno, strerror(errno));
+            }
+            return Result::ok();
+        }
+
+        Result load(FILE* file, size_t device) {
+            char header[64];
+            int fileVersion = 0;
+            unsigned long long start = 0;
+            unsigned long long step = 0;
+            unsigned int points = 0;
+
+            if (fscanf(file, "%63s %d %llu %llu %u", header, &fileVersion, &start, &step, &points) != 5 ||
+                strcmp(header, CALIBRATION_FILE_HEADER) != 0 || fileVersion != CALIBRATION_FILE_VERSION || step == 0 || points == 0) {
+                return Result("calibration_error", "Invalid calibration file `{}`", calibrationFileName(device));
+            }
+            shared_ptr<ErrorTerms> loaded = make_shared<ErrorTerms>();
+            loaded->start = start;
+            loaded->step = step;
+            loaded->resize(points);
+
+            for (size_t n = 0; n < points; n++) {
+                if (fscanf(file, "%f %f %f %f %f %f %f %f %f %f",
+                    &loaded->directivity.re[n], &loaded->directivity.im[n], &loaded->sourceMatch.re[n], &loaded->sourceMatch.im[n],
+                    &loaded->reflectionTracking.re[n], &loaded->reflectionTracking.im[n], &loaded->isolation.re[n], &loaded->isolation.im[n],
+                    &loaded->transmissionInverse.re[n], &loaded->transmissionInverse.im[n]) != 10) {
+                    return Result("calibration_error", "Invalid calibration file `{}` at point {}", calibrationFileName(device), n);
+                }
+            }
+            setTerms(device, loaded);
+
+            return Result::ok();
+        }
+
+#ifdef FAST_MATH_SSE2
+        // Splits 4 complex values into real and imaginary lanes
+        static void load4(const complex<float>* values, __m128& re, __m128& im) {
+            __m128 a = _mm_loadu_ps((const float*)values);
+            __m128 b = _mm_loadu_ps((const float*)(values + 2));
+
+            re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+
+        static void store4(complex<float>* values, __m128 re, __m128 im) {
+            _mm_storeu_ps((float*)values, _mm_unpacklo_ps(re, im));
+            _mm_storeu_ps((float*)(values + 2), _mm_unpackhi_ps(re, im));
+        }
+
+        static void multiply(__m128 aRe, __m128 aIm, __m128 bRe, __m128 bIm, __m128& re, __m128& im) {
+            __m128 r = _mm_sub_ps(_mm_mul_ps(aRe, bRe), _mm_mul_ps(aIm, bIm));
+            __m128 i = _mm_add_ps(_mm_mul_ps(aRe, bIm), _mm_mul_ps(aIm, bRe));
+
+            re = r;
+            im = i;
+        }
+#endif
+    };
+}
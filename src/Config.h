@@ -11,8 +11,27 @@ namespace litevnaserver {
     public:
         string version = "1.0.0";
         int tcpPort = 0;
-        string comPort;
+        vector<string> comPorts;
         string loggerFile;
+        size_t fifoChunk = 64;
+        uint16_t segmentPoints = 1024;
+        uint64_t sweepTimeout = 10000;
+        uint64_t pointTimeout = 10;
+        uint64_t cacheTtl = 0;
+
+        // Serial traces, see SerialRecorder and SerialReplay
+        string recordFile;
+        string replayFile;
+        bool replayFast = false;
+
+        // Host calibration error terms, see Calibration
+        string calibrationFile;
+
+        // Sweep repeated in background when `monitorPoints` > 0
+        uint64_t monitorStart = 0;
+        uint64_t monitorStep = 0;
+        uint32_t monitorPoints = 0;
+        uint16_t monitorAverage = 1;
 
         Config() = default;
         Config(const Config&) = delete;
@@ -33,7 +52,7 @@ namespace litevnaserver {
     private:
         Result parseArgs(int argc, char* argv[]) {
             int i = 1;
-            comPort.clear();
+            comPorts.clear();
             tcpPort = 0;
 
             while (i < argc) {
@@ -43,10 +62,10 @@ namespace litevnaserver {
                     if (optionValue.size() < 2) {
                         return Result("argument_error", "Option `-com-port` requires a value. Try `litevnaserver --help`");
                     }
-                    comPort = optionValue[1];
+                    comPorts = su::split(optionValue[1], ',', true);
 
-                    if (comPort.size() == 0) {
-                        return  Result("argument_error", "Invalid com port `{}`", comPort);
+                    if (comPorts.size() == 0) {
+                        return  Result("argument_error", "Invalid com port `{}`", optionValue[1]);
                     }
                 }
                 else if (optionValue[0] == "-tcp-port") {
@@ -60,6 +79,113 @@ namespace litevnaserver {
                         return  Result("argument_error", "Invalid tcp port `{}`", port);
                     }
                 }
+                else if (optionValue[0] == "-fifo-chunk") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-fifo-chunk` requires a value. Try `litevnaserver --help`");
+                    }
+                    bool error;
+                    fifoChunk = su::atou<size_t>(optionValue[1].data(), optionValue[1].size(), &error);
+
+                    if (error || fifoChunk > 255) {
+                        return  Result("argument_error", "Invalid fifo chunk `{}`", optionValue[1]);
+                    }
+                }
+                else if (optionValue[0] == "-segment-points") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-segment-points` requires a value. Try `litevnaserver --help`");
+                    }
+                    bool error;
+                    segmentPoints = su::atou<uint16_t>(optionValue[1].data(), optionValue[1].size(), &error);
+
+                    if (error || segmentPoints == 0) {
+                        return  Result("argument_error", "Invalid segment points `{}`", optionValue[1]);
+                    }
+                }
+                else if (optionValue[0] == "-sweep-timeout") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-sweep-timeout` requires a value. Try `litevnaserver --help`");
+                    }
+                    bool error;
+                    sweepTimeout = su::atou<uint64_t>(optionValue[1].data(), optionValue[1].size(), &error);
+
+                    if (error) {
+                        return  Result("argument_error", "Invalid sweep timeout `{}`", optionValue[1]);
+                    }
+                }
+                else if (optionValue[0] == "-point-timeout") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-point-timeout` requires a value. Try `litevnaserver --help`");
+                    }
+                    bool error;
+                    pointTimeout = su::atou<uint64_t>(optionValue[1].data(), optionValue[1].size(), &error);
+
+                    if (error) {
+                        return  Result("argument_error", "Invalid point timeout `{}`", optionValue[1]);
+                    }
+                }
+                else if (optionValue[0] == "-cache-ttl") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-cache-ttl` requires a value. Try `litevnaserver --help`");
+                    }
+                    bool error;
+                    cacheTtl = su::atou<uint64_t>(optionValue[1].data(), optionValue[1].size(), &error);
+
+                    if (error) {
+                        return  Result("argument_error", "Invalid cache ttl `{}`", optionValue[1]);
+                    }
+                }
+                else if (optionValue[0] == "-monitor") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-monitor` requires a value. Try `litevnaserver --help`");
+                    }
+                    vector<string> values = su::split(optionValue[1], ',', true);
+
+                    if (values.size() < 3 || values.size() > 4) {
+                        return  Result("argument_error", "Invalid monitor sweep `{}`", optionValue[1]);
+                    }
+                    bool errorStart;
+                    bool errorStep;
+                    bool errorPoints;
+                    bool errorAverage = false;
+                    monitorStart = su::atou<uint64_t>(values[0].data(), values[0].size(), &errorStart);
+                    monitorStep = su::atou<uint64_t>(values[1].data(), values[1].size(), &errorStep);
+                    monitorPoints = su::atou<uint32_t>(values[2].data(), values[2].size(), &errorPoints);
+
+                    if (values.size() > 3) {
+                        monitorAverage = su::atou<uint16_t>(values[3].data(), values[3].size(), &errorAverage);
+                    }
+                    if (errorStart || errorStep || errorPoints || errorAverage || monitorStart == 0 || monitorStep == 0 ||
+                        monitorPoints == 0 || monitorPoints > 100000 || monitorAverage == 0 || monitorAverage > 100) {
+                        return  Result("argument_error", "Invalid monitor sweep `{}`", optionValue[1]);
+                    }
+                }
+                else if (optionValue[0] == "-record") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-record` requires a value. Try `litevnaserver --help`");
+                    }
+                    recordFile = optionValue[1];
+                }
+                else if (optionValue[0] == "-replay") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-replay` requires a value. Try `litevnaserver --help`");
+                    }
+                    replayFile = optionValue[1];
+                }
+                else if (optionValue[0] == "-replay-speed") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-replay-speed` requires a value. Try `litevnaserver --help`");
+                    }
+                    if (optionValue[1] != "original" && optionValue[1] != "fast") {
+                        return  Result("argument_error", "Invalid replay speed `{}`", optionValue[1]);
+                    }
+                    replayFast = optionValue[1] == "fast";
+                }
+                else if (optionValue[0] == "-calibration-file") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-calibration-file` requires a value. Try `litevnaserver --help`");
+                    }
+                    calibrationFile = optionValue[1];
+                }
                 else if (optionValue[0] == "-logger-categories") {
                     if (optionValue.size() < 2) {
                         return Result("argument_error", "Option `-logger-categories` requires a value. Try `litevnaserver --help`");
@@ -110,7 +236,11 @@ namespace litevnaserver {
                 }
                 i++;
             }
-            if (comPort.size() == 0) {
+            // A replay needs no device, the com port only names it
+            if (comPorts.size() == 0 && replayFile.size() > 0) {
+                comPorts.push_back(replayFile);
+            }
+            if (comPorts.size() == 0) {
                 return Result("argument_error", "Missing `-com-port` option. Try `litevnaserver --help`");
             }
             if (tcpPort == 0) {
@@ -134,10 +264,37 @@ USAGE
     Options:
         --version                    Show version information.
         --help                       Display this information.
-        -com-port=<name>             (required) serial port where LiteVNA device is connected.
+        -com-port=<name>[,<name>...] (required) serial ports where LiteVNA devices are connected. Requests
+                                     go to the least loaded device, unless a device is requested.
         -tcp-port=<number>           (required) tcp port where LiteVNAServer will listen for requests.
         -logger-categories=<options> Comma separated options: http_server,lite_vna,info,error,all (default info,error).
         -logger-file=<file-name>     Logger output file (do not write to file by default).
+        -fifo-chunk=<points>         Points requested per Fifo read while the sweep runs, 0 to 255 (default 64).
+                                     0 waits for the whole sweep in a single request.
+        -segment-points=<points>     Maximum points of a single device sweep, 1 to 65535 (default 1024).
+                                     Larger requests are swept in segments and stitched together.
+        -sweep-timeout=<milliseconds>
+                                     Time allowed for a sweep, plus -point-timeout for each value
+                                     (points x avg) (default 10000).
+        -point-timeout=<milliseconds>
+                                     Time allowed for each value of a sweep (default 10).
+        -cache-ttl=<milliseconds>    Serve repeated requests from sweeps completed less than <milliseconds>
+                                     ago, including narrower grids of a cached sweep (default 0, disabled).
+        -monitor=<start>,<step>,<points>[,<avg>]
+                                     Sweep continuously in background, between requests. The latest
+                                     completed sweep is served at /litevna/latest (default disabled).
+        -record=<file-name>          Record every byte sent to and received from the device, with
+                                     timestamps, into a trace file (<file-name>.<device> with several
+                                     devices).
+        -replay=<file-name>          Replay a recorded trace instead of using a device, -com-port is
+                                     then optional. Requests must repeat the recorded ones, once the
+                                     trace ends its sweeps are replayed again.
+        -replay-speed=<speed>        original (default) delays received data as recorded, fast
+                                     delivers it at once.
+        -calibration-file=<file-name>
+                                     Load the host calibration from <file-name> at startup, and save
+                                     it there when a new one is captured (default not persisted).
+                                     With several devices, each one uses <file-name>.<index>.
 
     Example:
         litevnaserver -com-port={} -tcp-port=8888 -logger-categories=lite_vna,info,error
@@ -147,15 +304,81 @@ REQUEST
     Clients must send an HTML GET request with url containing all the following parameters:
         start     sweep start frequency in Hz.
         step      sweep step frequency in Hz.
-        points    number of sweep frequency points.
+        points    number of sweep frequency points (1 to 100000).
+
+    Optional parameters:
+        stream    1 sends the response with chunked transfer encoding, writing points as soon as
+                  they are received from the device.
+        avg       number of values measured for each frequency point (1 to 100, default 1), the
+                  response carries their mean.
+        precision exact (default) uses the C math library for log_mag, phase and swr. fast uses
+                  vectorized approximations, errors below 5e-5 dB (log_mag) and 2e-4 degrees (phase).
+        device    index of the device (in -com-port order) that must run the sweep.
+        std       1 adds the standard deviation of the averaged linear values as "std" to "s11"
+                  and "s21", when avg is greater than 1.
+        cal       device (default) uses the calibration stored in the device, host the calibration
+                  captured at /litevna/calibration (the sweep runs on the calibrated device, device
+                  is required when there are several), raw no calibration.
+        digits    significant digits of JSON numbers, 1 to 9 (default 6), or 0 for the fewest that read
+                  back as the same float.
+        format    json (default), bin (the binary sweep described in README.md), cbor (typed arrays,
+                  see README.md), csv, or s2p (Touchstone). bin and cbor are not available with
+                  stream. Without format, the Accept header chooses it.
+        sample    samples of format=bin: float32 (default), float16, or int16 scaled by a float32
+                  factor.
+        touchstone
+                  data format of format=s2p: ma (default, magnitude and angle), db or ri.
 
     Example:
         http://localhost:8888/litevna?start=4300000000&step=10000000&points=2
 
+    With -monitor, the latest completed background sweep is returned immediately at /litevna/latest
+    (optional parameters std, format, sample and touchstone as above), with "cached" false since it
+    does not come from an earlier request.
+
+    Example:
+        http://localhost:8888/litevna/latest
+
+    Continuous sweeps are sent as Server-Sent Events "sweep" to clients subscribed at /litevna/stream
+    using the same parameters. Sweeping stops when nobody is subscribed.
+
+    Example:
+        http://localhost:8888/litevna/stream?start=4300000000&step=10000000&points=2
+
+
+    Host calibration: /litevna/calibration?standard=<standard> with the same start, step, points
+    (and optional avg, device) captures a raw sweep of the standard connected to the device: short,
+    open, load (both ports terminated) and thru. Once the four standards are captured on the same
+    grid, requests with cal=host are corrected on any grid inside its range. Without standard it
+    returns the calibration status. Each device has its own calibration, so device is required
+    when there are several.
+
+    Example:
+        http://localhost:8888/litevna/calibration?standard=open&start=50000000&step=1000000&points=1001
+
+    /litevna/tdr runs the same sweep and returns the time domain reflection of s11 against distance.
+    Optional parameters:
+        response  impulse (default) or step. step needs start equal to step (lowpass mode), other
+                  sweeps return the impulse magnitude (bandpass mode).
+        window    kaiser (default), hann or none, applied to the spectrum.
+        beta      Kaiser window beta (0 to 50, default 6).
+        vf        velocity factor of the line (default 0.66).
+        distance  maximum distance in meters (default the unambiguous range, vf c / (2 step)).
+        bins      minimum number of distance bins up to distance (1 to 8192, default 256).
+        digits    significant digits of the numbers as above.
+
+    Example:
+        http://localhost:8888/litevna/tdr?start=1000000&step=1000000&points=1000&distance=20&vf=0.66
+
+    /litevna/ws accepts a WebSocket upgrade. Text messages with the same parameters subscribe to
+    continuous sweeps, "stop" unsubscribes. Each sweep is sent as one binary message of float32
+    values, or of the sample parameter's format (see README.md).
+
 
 RETURN VALUE
 
-    For a successful call, returns a JSON with a "result" field containing the scanned data.
+    For a successful call, returns a JSON with a "result" field containing the scanned data and a
+    "cached" field telling whether it was served from the sweep cache.
 
     Example:
 
@@ -185,7 +408,8 @@ RETURN VALUE
             "phase": -88.1427
           }
         }
-      ]
+      ],
+      "cached": false
     }
 
     If an error occurs, returns a JSON with an "error" field with a description.
@@ -0,0 +1,164 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include "SweepService.h"
+
+namespace litevnaserver {
+    // One LiteVNA and one SweepService (acquisition thread and queues) per `Config::comPorts` entry.
+    // Jobs go to the requested device, or to the least loaded one. The background sweep, if any,
+    // runs on device 0. Used only from the event loop thread.
+    class DevicePool {
+    public:
+        // 1. Lifecycle
+        DevicePool() = default;
+        DevicePool(const DevicePool&) = delete;
+        DevicePool& operator=(const DevicePool&) = delete;
+        DevicePool(const DevicePool&&) = delete;
+        DevicePool& operator=(const DevicePool&&) = delete;
+        ~DevicePool() = default;
+
+        Result initialize() {
+            for (size_t n = 0; n < config->comPorts.size(); n++) {
+                unique_ptr<LiteVNA> liteVNA = make_unique<LiteVNA>();
+                liteVNA->setConfig(config);
+                liteVNA->setComPort(config->comPorts[n]);
+                liteVNA->setSerial(createSerial(n));
+
+                Result result = liteVNA->initialize();
+
+                if (result) {
+                    return result;
+                }
+                liteVNAs.push_back(move(liteVNA));
+
+                unique_ptr<SweepService> sweepService = make_unique<SweepService>();
+                sweepService->setConfig(config);
+                sweepService->setLiteVNA(liteVNAs.back().get());
+                sweepService->setDevice(n);
+                sweepService->onWakeup(wakeupCallback);
+
+                result = sweepService->initialize();
+
+                if (result) {
+                    return result;
+                }
+                sweepServices.push_back(move(sweepService));
+            }
+            return Result::ok();
+        }
+
+        void terminate() {
+            for (auto& sweepService : sweepServices) {
+                sweepService->terminate();
+            }
+            for (auto& liteVNA : liteVNAs) {
+                liteVNA->terminate();
+            }
+        }
+
+        // 2. Dependency injection
+        void setConfig(Config* _config) {
+            config = _config;
+        }
+
+        // Called from the device threads every time a job completes
+        void onWakeup(SweepService::WakeupCallback callback) {
+            wakeupCallback = callback;
+
+            for (auto& sweepService : sweepServices) {
+                sweepService->onWakeup(callback);
+            }
+        }
+
+        // 3. Functionalities
+        size_t size() const {
+            return config->comPorts.size();
+        }
+
+        // Runs `job` on `job->spec.device`, or on the least loaded device if it is -1
+        bool submit(shared_ptr<SweepJob> job) {
+            size_t device = job->spec.device >= 0 ? (size_t)job->spec.device : leastLoaded();
+
+            job->id = ++lastJobId;
+            job->device = device;
+
+            return sweepServices[device]->submit(job);
+        }
+
+        // Hands every completed job of every device to `callback`
+        void poll(const function<void(shared_ptr<SweepJob>)>& callback) {
+            for (auto& sweepService : sweepServices) {
+                sweepService->poll(callback);
+            }
+        }
+
+        size_t getInFlight() const {
+            size_t inFlight = 0;
+
+            for (auto& sweepService : sweepServices) {
+                inFlight += sweepService->getInFlight();
+            }
+            return inFlight;
+        }
+
+        bool isMonitoring() const {
+            return sweepServices[0]->isMonitoring();
+        }
+
+        shared_ptr<SweepJob> getLatest() const {
+            return sweepServices[0]->getLatest();
+        }
+
+    private:
+        Config* config = nullptr;
+        SweepService::WakeupCallback wakeupCallback = nullptr;
+        vector<unique_ptr<LiteVNA>> liteVNAs;
+        vector<unique_ptr<SweepService>> sweepServices;
+        uint64_t lastJobId = 0;
+
+        // SerialPort, or a replay of `Config::replayFile`, recorded into `Config::recordFile` if set
+        unique_ptr<SerialTransport> createSerial(size_t device) {
+            unique_ptr<SerialTransport> serial;
+
+            if (config->replayFile.size() > 0) {
+                unique_ptr<SerialReplay> replay = make_unique<SerialReplay>();
+                replay->setFileName(traceFileName(config->replayFile, device));
+                replay->setSpeed(config->replayFast ? ReplaySpeed::Fast : ReplaySpeed::Original);
+                serial = move(replay);
+            }
+            else {
+                serial = make_unique<SerialPort>();
+            }
+            if (config->recordFile.size() > 0) {
+                unique_ptr<SerialRecorder> recorder = make_unique<SerialRecorder>();
+                recorder->setFileName(traceFileName(config->recordFile, device));
+                recorder->setTransport(move(serial));
+                serial = move(recorder);
+            }
+            return serial;
+        }
+
+        // One trace per device, numbered when there are several
+        string traceFileName(const string& fileName, size_t device) const {
+            return size() > 1 ? su::format("{}.{}", fileName, device) : fileName;
+        }
+
+        // The background sweep counts as one job, so requests prefer the other devices
+        size_t leastLoaded() const {
+            size_t device = 0;
+            size_t minLoad = SIZE_MAX;
+
+            for (size_t n = 0; n < sweepServices.size(); n++) {
+                size_t load = sweepServices[n]->getInFlight() + (sweepServices[n]->isMonitoring() ? 1 : 0);
+
+                if (load < minLoad) {
+                    device = n;
+                    minLoad = load;
+                }
+            }
+            return device;
+        }
+    };
+}
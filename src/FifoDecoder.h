@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <stdint.h>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FIFO_DECODER_SSE2
+#include <emmintrin.h>
+#endif
+
+#if defined(__AVX2__)
+#define FIFO_DECODER_AVX2
+#include <immintrin.h>
+#endif
+
+#define FIFO_DECODER_CHECKSUM_SEED 0x46
+
+namespace litevnaserver {
+    using namespace std;
+
+#pragma pack(push, 1)
+    struct LiteVNAFifoData
+    {
+        int32_t  channel0OutRe;
+        int32_t  channel0OutIm;
+        int32_t  channel0InRe;
+        int32_t  channel0InIm;
+        int32_t  channel1InRe;
+        int32_t  channel1InIm;
+        uint16_t freqIndex;
+        uint8_t  reserved[5];
+        uint8_t  checksum;
+    };
+#pragma pack(pop)
+
+    // Decoded frames as structure of arrays, channel inputs are already divided by channel 0 output
+    struct FifoFrames {
+        vector<float> channel0OutRe;
+        vector<float> channel0OutIm;
+        vector<float> channel0InRe;
+        vector<float> channel0InIm;
+        vector<float> channel1InRe;
+        vector<float> channel1InIm;
+        vector<uint16_t> freqIndex;
+
+        explicit FifoFrames(size_t capacity) : channel0OutRe(capacity), channel0OutIm(capacity), channel0InRe(capacity),
+            channel0InIm(capacity), channel1InRe(capacity), channel1InIm(capacity), freqIndex(capacity) {
+        }
+
+        size_t capacity() const {
+            return freqIndex.size();
+        }
+    };
+
+    // Batch decoder of contiguous LiteVNA Fifo frames. Checksums are verified 16 frames at a time
+    // with SSE2 (byte transposition), and the conversion and complex divisions run 4 frames at a
+    // time with SSE2, or 8 with AVX2 when compiled for it. Other targets use the scalar code, which
+    // also handles the remaining frames. Every path computes a / b as a * conj(b) / |b|^2, so results
+    // do not depend on the path.
+    class FifoDecoder {
+    public:
+        // Returns the index of the first frame with an invalid checksum, or `count` if all are valid
+        static size_t verify(const uint8_t* frames, size_t count) {
+            size_t n = 0;
+
+#ifdef FIFO_DECODER_SSE2
+            for (; n + 16 <= count; n += 16) {
+                if (!verify16(frames + n * sizeof(LiteVNAFifoData))) {
+                    break;
+                }
+            }
+#endif
+            for (; n < count; n++) {
+                const uint8_t* frame = frames + n * sizeof(LiteVNAFifoData);
+
+                if (checksum(frame) != frame[sizeof(LiteVNAFifoData) - 1]) {
+                    return n;
+                }
+            }
+            return count;
+        }
+
+        static uint8_t checksum(const uint8_t* frame) {
+            uint8_t value = FIFO_DECODER_CHECKSUM_SEED;
+
+            for (size_t i = 0; i < (sizeof(LiteVNAFifoData) - 1); i++) {
+                value = (value ^ ((value << 1) | 1u)) ^ frame[i];
+            }
+            return value;
+        }
+
+        // Converts `count` frames (at most `out.capacity()`), already verified
+        static void convert(const uint8_t* frames, size_t count, FifoFrames& out) {
+            size_t n = 0;
+
+#if defined(FIFO_DECODER_AVX2)
+            for (; n + 8 <= count; n += 8) {
+                convert8(frames + n * sizeof(LiteVNAFifoData), out, n);
+            }
+#elif defined(FIFO_DECODER_SSE2)
+            for (; n + 4 <= count; n += 4) {
+                convert4(frames + n * sizeof(LiteVNAFifoData), out, n);
+            }
+#endif
+            for (; n < count; n++) {
+                const LiteVNAFifoData* fifo = (const LiteVNAFifoData*)(frames + n * sizeof(LiteVNAFifoData));
+                float outRe = (float)fifo->channel0OutRe;
+                float outIm = (float)fifo->channel0OutIm;
+                float inverse = 1.0f / (outRe * outRe + outIm * outIm);
+                float in0Re = (float)fifo->channel0InRe;
+                float in0Im = (float)fifo->channel0InIm;
+                float in1Re = (float)fifo->channel1InRe;
+                float in1Im = (float)fifo->channel1InIm;
+
+                out.channel0OutRe[n] = outRe;
+                out.channel0OutIm[n] = outIm;
+                out.channel0InRe[n] = (in0Re * outRe + in0Im * outIm) * inverse;
+                out.channel0InIm[n] = (in0Im * outRe - in0Re * outIm) * inverse;
+                out.channel1InRe[n] = (in1Re * outRe + in1Im * outIm) * inverse;
+                out.channel1InIm[n] = (in1Im * outRe - in1Re * outIm) * inverse;
+                out.freqIndex[n] = fifo->freqIndex;
+            }
+        }
+
+    private:
+#ifdef FIFO_DECODER_SSE2
+        // After the transposition, vector `i` holds byte `i` of the 16 frames, lane `k` is frame `k`
+        static bool verify16(const uint8_t* frames) {
+            __m128i low[16];
+            __m128i high[16];
+
+            for (size_t k = 0; k < 16; k++) {
+                low[k] = _mm_loadu_si128((const __m128i*)(frames + k * sizeof(LiteVNAFifoData)));
+                high[k] = _mm_loadu_si128((const __m128i*)(frames + k * sizeof(LiteVNAFifoData) + 16));
+            }
+            transpose16(low);
+            transpose16(high);
+
+            const __m128i one = _mm_set1_epi8(1);
+            __m128i value = _mm_set1_epi8(FIFO_DECODER_CHECKSUM_SEED);
+
+            for (size_t i = 0; i < (sizeof(LiteVNAFifoData) - 1); i++) {
+                __m128i byte = i < 16 ? low[i] : high[i - 16];
+                __m128i shifted = _mm_or_si128(_mm_add_epi8(value, value), one);
+
+                value = _mm_xor_si128(_mm_xor_si128(value, shifted), byte);
+            }
+            return _mm_movemask_epi8(_mm_cmpeq_epi8(value, high[15])) == 0xFFFF;
+        }
+
+        static void transpose16(__m128i* rows) {
+            __m128i next[16];
+
+            for (size_t stage = 0; stage < 4; stage++) {
+                for (size_t j = 0; j < 8; j++) {
+                    next[2 * j] = _mm_unpacklo_epi8(rows[j], rows[j + 8]);
+                    next[2 * j + 1] = _mm_unpackhi_epi8(rows[j], rows[j + 8]);
+                }
+                for (size_t j = 0; j < 16; j++) {
+                    rows[j] = next[j];
+                }
+            }
+        }
+
+        static void divide4(__m128 aRe, __m128 aIm, __m128 bRe, __m128 bIm, float* re, float* im) {
+            __m128 inverse = _mm_div_ps(_mm_set1_ps(1.0f), _mm_add_ps(_mm_mul_ps(bRe, bRe), _mm_mul_ps(bIm, bIm)));
+
+            _mm_storeu_ps(re, _mm_mul_ps(_mm_add_ps(_mm_mul_ps(aRe, bRe), _mm_mul_ps(aIm, bIm)), inverse));
+            _mm_storeu_ps(im, _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(aIm, bRe), _mm_mul_ps(aRe, bIm)), inverse));
+        }
+
+        static void convert4(const uint8_t* frames, FifoFrames& out, size_t n) {
+            __m128 low[4];
+            __m128 high[4];
+
+            for (size_t k = 0; k < 4; k++) {
+                const uint8_t* frame = frames + k * sizeof(LiteVNAFifoData);
+
+                low[k] = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)frame));
+                high[k] = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i*)(frame + 16)));
+                out.freqIndex[n + k] = ((const LiteVNAFifoData*)frame)->freqIndex;
+            }
+            _MM_TRANSPOSE4_PS(low[0], low[1], low[2], low[3]);
+            _MM_TRANSPOSE4_PS(high[0], high[1], high[2], high[3]);
+
+            _mm_storeu_ps(&out.channel0OutRe[n], low[0]);
+            _mm_storeu_ps(&out.channel0OutIm[n], low[1]);
+            divide4(low[2], low[3], low[0], low[1], &out.channel0InRe[n], &out.channel0InIm[n]);
+            divide4(high[0], high[1], low[0], low[1], &out.channel1InRe[n], &out.channel1InIm[n]);
+        }
+#endif
+
+#ifdef FIFO_DECODER_AVX2
+        static void divide8(__m256 aRe, __m256 aIm, __m256 bRe, __m256 bIm, float* re, float* im) {
+            __m256 inverse = _mm256_div_ps(_mm256_set1_ps(1.0f), _mm256_add_ps(_mm256_mul_ps(bRe, bRe), _mm256_mul_ps(bIm, bIm)));
+
+            _mm256_storeu_ps(re, _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(aRe, bRe), _mm256_mul_ps(aIm, bIm)), inverse));
+            _mm256_storeu_ps(im, _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(aIm, bRe), _mm256_mul_ps(aRe, bIm)), inverse));
+        }
+
+        // A frame is exactly eight 32 bits words, so 8 frames are transposed as an 8x8 matrix
+        static void convert8(const uint8_t* frames, FifoFrames& out, size_t n) {
+            __m256 rows[8];
+
+            for (size_t k = 0; k < 8; k++) {
+                const uint8_t* frame = frames + k * sizeof(LiteVNAFifoData);
+
+                rows[k] = _mm256_cvtepi32_ps(_mm256_loadu_si256((const __m256i*)frame));
+                out.freqIndex[n + k] = ((const LiteVNAFifoData*)frame)->freqIndex;
+            }
+            __m256 t0 = _mm256_unpacklo_ps(rows[0], rows[1]);
+            __m256 t1 = _mm256_unpackhi_ps(rows[0], rows[1]);
+            __m256 t2 = _mm256_unpacklo_ps(rows[2], rows[3]);
+            __m256 t3 = _mm256_unpackhi_ps(rows[2], rows[3]);
+            __m256 t4 = _mm256_unpacklo_ps(rows[4], rows[5]);
+            __m256 t5 = _mm256_unpackhi_ps(rows[4], rows[5]);
+            __m256 t6 = _mm256_unpacklo_ps(rows[6], rows[7]);
+            __m256 t7 = _mm256_unpackhi_ps(rows[6], rows[7]);
+            __m256 s0 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 s1 = _mm256_shuffle_ps(t0, t2, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 s2 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 s3 = _mm256_shuffle_ps(t1, t3, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 s4 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 s5 = _mm256_shuffle_ps(t4, t6, _MM_SHUFFLE(3, 2, 3, 2));
+            __m256 s6 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(1, 0, 1, 0));
+            __m256 s7 = _mm256_shuffle_ps(t5, t7, _MM_SHUFFLE(3, 2, 3, 2));
+
+            __m256 outRe = _mm256_permute2f128_ps(s0, s4, 0x20);
+            __m256 outIm = _mm256_permute2f128_ps(s1, s5, 0x20);
+            __m256 in0Re = _mm256_permute2f128_ps(s2, s6, 0x20);
+            __m256 in0Im = _mm256_permute2f128_ps(s3, s7, 0x20);
+            __m256 in1Re = _mm256_permute2f128_ps(s0, s4, 0x31);
+            __m256 in1Im = _mm256_permute2f128_ps(s1, s5, 0x31);
+
+            _mm256_storeu_ps(&out.channel0OutRe[n], outRe);
+            _mm256_storeu_ps(&out.channel0OutIm[n], outIm);
+            divide8(in0Re, in0Im, outRe, outIm, &out.channel0InRe[n], &out.channel0InIm[n]);
+            divide8(in1Re, in1Im, outRe, outIm, &out.channel1InRe[n], &out.channel1InIm[n]);
+        }
+#endif
+    };
+}
@@ -3,7 +3,19 @@
 
 #pragma once
 
+#include <algorithm>
+
 #include "lib/SocketTCP.h"
+#include "lib/WebSocket.h"
+
+#define HTTP_SERVER_STREAM_POINTS 256
+#define HTTP_SERVER_SUBSCRIPTION_RETRY_MS 1000
+#define HTTP_SERVER_WEBSOCKET_MAX_MESSAGE (64 * 1024)
+#define HTTP_SERVER_WEBSOCKET_CLOSE_MS 1000
+#define HTTP_SERVER_CHUNK_HEADER_SIZE 10
+#define HTTP_SERVER_MAX_AVERAGE 100
+#define HTTP_SERVER_MAX_POINTS 100000
+#define HTTP_SERVER_DEFAULT_DIGITS 6
 
 namespace litevnaserver {
     class HTTPServer {
@@ -33,6 +45,14 @@ namespace litevnaserver {
                 this->onRead(socketId, totalAvailable);
             });
 
+            socket->onClose([this](uint64_t socketId, void* /*customData*/) {
+                this->onClose(socketId);
+            });
+
+            devicePool->onWakeup([this]() {
+                socket->signal();
+            });
+
             LOGGER(Info, "HTTP server listening at tcp port {}", config->tcpPort);
 
             return Result::ok();
@@ -47,8 +67,16 @@ namespace litevnaserver {
             config = _config;
         }
 
-        void setLiteVNA(LiteVNA* _liteVNA) {
-            liteVNA = _liteVNA;
+        void setDevicePool(DevicePool* _devicePool) {
+            devicePool = _devicePool;
+        }
+
+        void setSweepCache(SweepCache* _sweepCache) {
+            sweepCache = _sweepCache;
+        }
+
+        void setCalibration(Calibration* _calibration) {
+            calibration = _calibration;
         }
 
         // 3. Functionalities
@@ -56,15 +84,55 @@ namespace litevnaserver {
             Result result;
 
             while (!result) {
-                result = socket->select(100, nullptr);
+                // The device thread wakes `select` up when a sweep completes (Linux). On Windows it is
+                // polled, so use a short timeout while sweeps are in flight.
+                result = socket->select(devicePool->getInFlight() > 0 ? 5 : 100, nullptr);
+
+                onSweepProgress();
+                resumeSubscriptions();
+                closeWebSockets();
+
+                devicePool->poll([this](shared_ptr<SweepJob> job) {
+                    this->onSweepCompleted(job);
+                });
             }
             return result;
         }
 
     private:
-        LiteVNA* liteVNA = nullptr;
+        DevicePool* devicePool = nullptr;
+        SweepCache* sweepCache = nullptr;
+        Calibration* calibration = nullptr;
         Config* config = nullptr;
         unique_ptr<SocketTCP> socket = make_unique<SocketTCP>();
+        ScanMetrics metrics;
+        TDR tdr;
+
+        struct Subscription {
+            vector<uint64_t> socketIds;
+            uint64_t resumeAt = 0;
+        };
+
+        unordered_map<uint64_t, shared_ptr<SweepJob>> pendingSweeps;
+        // Queued or running sweeps, identical requests attach to them instead of sweeping again
+        unordered_map<SweepSpec, shared_ptr<SweepJob>, SweepSpecHash> runningSweeps;
+        unordered_map<SweepSpec, Subscription, SweepSpecHash> subscriptions;
+        unordered_map<uint64_t, SweepSpec> subscribers;
+        // Sweeps capturing a calibration standard, by job id
+        unordered_map<uint64_t, CalibrationStandard> captures;
+
+        struct WebSocketClient {
+            string buffer;
+            string message;
+            // A fragmented message is being received
+            bool fragmented = false;
+            bool closing = false;
+            // Monotonic time at which the server closes the tcp connection, once `closing`
+            uint64_t closeAt = 0;
+            shared_ptr<SweepEncoder> encoder = make_shared<BinaryEncoder>(SampleFormat::Float32);
+        };
+
+        unordered_map<uint64_t, WebSocketClient> webSockets;
 
         void onRead(uint64_t socketId, size_t totalAvailable) {
             char* buffer = new char[totalAvailable];
@@ -80,6 +148,12 @@ namespace litevnaserver {
             string received(buffer, totalRead);
             delete[] buffer;
 
+            auto webSocket = webSockets.find(socketId);
+
+            if (webSocket != webSockets.end()) {
+                onWebSocketRead(socketId, webSocket->second, received);
+                return;
+            }
             LOGGER(HTTPServer, "Request received (socket_id={}): {}", socketId, received);
 
             vector<string> lines = su::split(received, '\r', true);
@@ -95,16 +169,54 @@ namespace litevnaserver {
                 return;
             }
             vector<string> url = su::split(request[1], '?', false);
+            unordered_map<string, string> headers = parseHeaders(lines);
 
-            if (url.size() < 1 || url[0] != "/litevna") {
+            if (url.size() < 1 || (url[0] != "/litevna" && url[0] != "/litevna/stream" && url[0] != "/litevna/ws" && url[0] != "/litevna/latest" && url[0] != "/litevna/calibration" &&
+                url[0] != "/litevna/tdr")) {
                 write(socketId, "HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\nNot Found");
                 return;
             }
+            if (url[0] == "/litevna/ws") {
+                onWebSocketUpgrade(socketId, headers, url.size() > 1 ? parseParams(url[1]) : unordered_map<string, string>());
+                return;
+            }
+            if (url[0] == "/litevna/latest") {
+                onLatestRequest(socketId, url.size() > 1 ? parseParams(url[1]) : unordered_map<string, string>(), headers["accept"]);
+                return;
+            }
+            if (url[0] == "/litevna/calibration") {
+                onCalibrationRequest(socketId, url.size() > 1 ? parseParams(url[1]) : unordered_map<string, string>());
+                return;
+            }
             if (url.size() < 2) {
                 write(socketId, "HTTP/1.1 400 Bad Request\r\nContent-Length: 11\r\n\r\nBad Request");
                 return;
             }
-            vector<string> sParams = su::split(url[1], '&', false);
+            unordered_map<string, string> params = parseParams(url[1]);
+
+            if (url[0] == "/litevna/stream") {
+                onSubscribeRequest(socketId, params);
+                return;
+            }
+            onSweepRequest(socketId, params, headers["accept"], url[0] == "/litevna/tdr");
+        }
+
+        // Header names in lower case
+        static unordered_map<string, string> parseHeaders(const vector<string>& lines) {
+            unordered_map<string, string> headers;
+
+            for (size_t n = 1; n < lines.size(); n++) {
+                size_t pos = lines[n].find(':');
+
+                if (pos != string::npos) {
+                    headers[su::toLower(su::trim(lines[n].substr(0, pos)))] = su::trim(lines[n].substr(pos + 1));
+                }
+            }
+            return headers;
+        }
+
+        static unordered_map<string, string> parseParams(const string& query) {
+            vector<string> sParams = su::split(query, '&', false);
             unordered_map<string, string> params;
 
             for (auto param : sParams) {
@@ -114,24 +226,692 @@ namespace litevnaserver {
                     params.emplace(keyValue[0], keyValue[1]);
                 }
             }
-            string json = execute(params);
-            string response = su::format("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Type: application/json\r\nContent-Length: {}\r\n\r\n{}", json.size(), json);
+            return params;
+        }
+
+        // /litevna, or /litevna/tdr if `tdr`: the same sweep, shared and cached alike, with a time domain output
+        void onSweepRequest(uint64_t socketId, unordered_map<string, string>& params, const string& accept, bool tdr) {
+            if (pendingSweeps.find(socketId) != pendingSweeps.end()) {
+                writeJSON(socketId, "503 Service Unavailable", R"({"error": "previous request still running"})");
+                return;
+            }
+            shared_ptr<SweepJob> job = make_shared<SweepJob>();
+            string error = parseSpec(params, job->spec);
+
+            if (error.size() > 0) {
+                writeJSON(socketId, "200 OK", error);
+                return;
+            }
+            SweepWaiter waiter;
+            waiter.socketId = socketId;
+            waiter.streaming = !tdr && params.find("stream") != params.end() && params["stream"] == "1";
+            error = tdr ? parseTDR(params, job->spec, waiter) : parseOutput(params, accept, waiter.encoder);
+
+            if (error.size() == 0 && waiter.streaming && !waiter.encoder->isStreamable()) {
+                error = errorJSON(su::format("'stream' is not available with {}", waiter.encoder->contentType()));
+            }
+            if (error.size() > 0) {
+                writeJSON(socketId, "200 OK", error);
+                return;
+            }
+
+            shared_ptr<SweepJob> cached = sweepCache->find(job->spec);
 
-            write(socketId, response);
+            if (cached) {
+                LOGGER(HTTPServer, "Request (socket_id={}) served from cached sweep {}", socketId, cached->id);
+
+                if (waiter.streaming) {
+                    writeStreamBegin(waiter, *cached);
+                    writeStreamPoints(waiter, *cached, cached->spec.points);
+                    writeStreamEnd(waiter, *cached, true);
+                    return;
+                }
+                if (waiter.tdr) {
+                    writeJSON(socketId, "200 OK", toTDRJSON(*cached, waiter, true));
+                    return;
+                }
+                writeSweep(socketId, *waiter.encoder, *cached, true);
+                return;
+            }
+            auto running = runningSweeps.find(job->spec);
+
+            if (running != runningSweeps.end()) {
+                job = running->second;
+
+                LOGGER(HTTPServer, "Request (socket_id={}) attached to sweep {}", socketId, job->id);
+            }
+            else {
+                job->streaming = waiter.streaming;
+
+                if (!submit(job)) {
+                    writeJSON(socketId, "503 Service Unavailable", R"({"error": "too many requests"})");
+                    return;
+                }
+                runningSweeps[job->spec] = job;
+            }
+            if (waiter.streaming) {
+                job->streaming = true;
+                writeStreamBegin(waiter, *job);
+            }
+            job->waiters.push_back(waiter);
+            pendingSweeps[socketId] = job;
         }
 
-        void write(uint64_t socketId, const string& text) {
+        // Host calibration of a device: without other parameters returns its status, with `standard` and the
+        // sweep parameters captures a raw sweep of that standard on the device. Captures always sweep, they
+        // are neither shared nor cached.
+        void onCalibrationRequest(uint64_t socketId, unordered_map<string, string> params) {
+            size_t device = 0;
+            string error = parseCalibrationDevice(params, device);
+
+            if (error.size() > 0) {
+                writeJSON(socketId, "200 OK", error);
+                return;
+            }
+            if (params.size() == params.count("device")) {
+                writeJSON(socketId, "200 OK", calibrationStatusJSON(device));
+                return;
+            }
+            if (pendingSweeps.find(socketId) != pendingSweeps.end()) {
+                writeJSON(socketId, "503 Service Unavailable", R"({"error": "previous request still running"})");
+                return;
+            }
+            auto standardParam = params.find("standard");
+
+            if (standardParam == params.end()) {
+                writeJSON(socketId, "200 OK", R"({"error": "missing 'standard' parameter"})");
+                return;
+            }
+            CalibrationStandard standards[] = { CalibrationStandard::Short, CalibrationStandard::Open, CalibrationStandard::Load, CalibrationStandard::Thru };
+            auto standard = find_if(begin(standards), end(standards), [&standardParam](CalibrationStandard candidate) {
+                return standardParam->second == Calibration::toString(candidate);
+            });
+
+            if (standard == end(standards)) {
+                writeJSON(socketId, "200 OK", R"({"error": "invalid 'standard' parameter"})");
+                return;
+            }
+            params.erase("cal");
+
+            shared_ptr<SweepJob> job = make_shared<SweepJob>();
+            error = parseSpec(params, job->spec);
+
+            if (error.size() > 0) {
+                writeJSON(socketId, "200 OK", error);
+                return;
+            }
+            job->spec.device = (int)device;
+            job->spec.calibration = SweepCalibration::Raw;
+
+            if (!devicePool->submit(job)) {
+                writeJSON(socketId, "503 Service Unavailable", R"({"error": "too many requests"})");
+                return;
+            }
+            LOGGER(HTTPServer, "Request (socket_id={}) captures standard {} of device {} with sweep {}", socketId, Calibration::toString(*standard), device, job->id);
+
+            captures[job->id] = *standard;
+
+            SweepWaiter waiter;
+            waiter.socketId = socketId;
+            job->waiters.push_back(waiter);
+            pendingSweeps[socketId] = job;
+        }
+
+        void onCaptureCompleted(shared_ptr<SweepJob> job, CalibrationStandard standard) {
+            Result result = job->result;
+
+            if (!result) {
+                result = calibration->capture(job->device, standard, job->spec.start, job->spec.step, job->spec.points, job->values);
+            }
+            string json = result ? errorJSON(result.description) : calibrationStatusJSON(job->device);
+
+            for (SweepWaiter& waiter : job->waiters) {
+                pendingSweeps.erase(waiter.socketId);
+                writeJSON(waiter.socketId, "200 OK", json);
+            }
+        }
+
+        string calibrationStatusJSON(size_t device) const {
+            string captured;
+
+            for (CalibrationStandard standard : { CalibrationStandard::Short, CalibrationStandard::Open, CalibrationStandard::Load, CalibrationStandard::Thru }) {
+                if (calibration->isCaptured(device, standard)) {
+                    captured += su::format(R"({}"{}")", captured.size() > 0 ? ", " : "", Calibration::toString(standard));
+                }
+            }
+            shared_ptr<const ErrorTerms> terms = calibration->getTerms(device);
+
+            if (!terms) {
+                return su::format(R"({"device": {}, "captured": [{}], "complete": false})", device, captured);
+            }
+            return su::format(R"({"device": {}, "captured": [{}], "complete": true, "start": {}, "step": {}, "points": {}})", device, captured, terms->start, terms->step, terms->points);
+        }
+
+        // Latest background sweep, it never waits for the device
+        void onLatestRequest(uint64_t socketId, const unordered_map<string, string>& params, const string& accept) {
+            if (!devicePool->isMonitoring()) {
+                writeJSON(socketId, "404 Not Found", R"({"error": "background sweep is disabled"})");
+                return;
+            }
+            shared_ptr<SweepJob> latest = devicePool->getLatest();
+
+            if (!latest) {
+                writeJSON(socketId, "503 Service Unavailable", R"({"error": "no background sweep completed yet"})");
+                return;
+            }
+            shared_ptr<SweepEncoder> encoder;
+            string error = parseOutput(params, accept, encoder);
+
+            if (error.size() > 0) {
+                writeJSON(socketId, "200 OK", error);
+                return;
+            }
+            // "cached" tells that an earlier request supplied the result, a background sweep was never requested
+            writeSweep(socketId, *encoder, *latest, false);
+        }
+
+        // Server-Sent Events: the subscriber receives every new sweep of its spec as an event. Subscribers
+        // of the same spec share the sweep and the encoded event, sweeping stops when nobody is subscribed.
+        void onSubscribeRequest(uint64_t socketId, unordered_map<string, string>& params) {
+            SweepSpec spec;
+            string error = parseSpec(params, spec);
+
+            if (error.size() > 0) {
+                writeJSON(socketId, "200 OK", error);
+                return;
+            }
+            if (subscribers.find(socketId) != subscribers.end()) {
+                writeJSON(socketId, "409 Conflict", R"({"error": "already subscribed"})");
+                return;
+            }
+            write(socketId, "HTTP/1.1 200 OK\r\nContent-Type: text/event-stream\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n\r\n");
+            subscribe(socketId, spec);
+        }
+
+        void subscribe(uint64_t socketId, const SweepSpec& spec) {
+            Subscription& subscription = subscriptions[spec];
+            subscription.socketIds.push_back(socketId);
+            subscribers[socketId] = spec;
+
+            LOGGER(HTTPServer, "Subscription (socket_id={}) to start={}, step={}, points={}, total subscribers {}",
+                socketId, spec.start, spec.step, spec.points, subscription.socketIds.size());
+
+            sweepSubscription(spec, subscription);
+        }
+
+        void unsubscribe(uint64_t socketId) {
+            auto subscriber = subscribers.find(socketId);
+
+            if (subscriber == subscribers.end()) {
+                return;
+            }
+            auto it = subscriptions.find(subscriber->second);
+            vector<uint64_t>& socketIds = it->second.socketIds;
+
+            socketIds.erase(remove(socketIds.begin(), socketIds.end(), socketId), socketIds.end());
+
+            if (socketIds.size() == 0) {
+                subscriptions.erase(it);
+            }
+            subscribers.erase(subscriber);
+        }
+
+        // Queues the next sweep of a subscription, unless one with the same spec is already running
+        void sweepSubscription(const SweepSpec& spec, Subscription& subscription) {
+            subscription.resumeAt = 0;
+
+            if (runningSweeps.find(spec) != runningSweeps.end()) {
+                return;
+            }
+            shared_ptr<SweepJob> job = make_shared<SweepJob>();
+            job->spec = spec;
+
+            if (!submit(job)) {
+                subscription.resumeAt = DateTime::monotonicMilliseconds() + HTTP_SERVER_SUBSCRIPTION_RETRY_MS;
+                return;
+            }
+            runningSweeps[spec] = job;
+        }
+
+        // Restarts subscriptions paused by a failed sweep or a full queue
+        void resumeSubscriptions() {
+            uint64_t now = 0;
+
+            for (auto& it : subscriptions) {
+                if (it.second.resumeAt == 0) {
+                    continue;
+                }
+                if (now == 0) {
+                    now = DateTime::monotonicMilliseconds();
+                }
+                if (it.second.resumeAt <= now) {
+                    sweepSubscription(it.first, it.second);
+                }
+            }
+        }
+
+        void publish(shared_ptr<SweepJob> job) {
+            auto it = subscriptions.find(job->spec);
+
+            if (it == subscriptions.end()) {
+                return;
+            }
+            Subscription& subscription = it->second;
+            // Each encoding is built once and shared by every subscriber using it
+            shared_ptr<string> event;
+            unordered_map<string, shared_ptr<string>> frames;
+
+            for (uint64_t socketId : subscription.socketIds) {
+                auto webSocket = webSockets.find(socketId);
+
+                if (webSocket != webSockets.end()) {
+                    SweepEncoder& encoder = *webSocket->second.encoder;
+                    shared_ptr<string>& frame = frames[job->result ? "" : encoder.variant()];
+
+                    if (!frame) {
+                        string payload;
+
+                        if (!job->result) {
+                            encoder.encode(payload, *job, false);
+                        }
+                        frame = make_shared<string>(job->result ?
+                            WebSocket::encodeFrame(WEBSOCKET_OPCODE_TEXT, errorJSON(job->result.description)) :
+                            WebSocket::encodeFrame(WEBSOCKET_OPCODE_BINARY, payload));
+                    }
+                    write(socketId, frame);
+                    continue;
+                }
+                if (!event) {
+                    if (job->result) {
+                        event = make_shared<string>("event: error\ndata: " + errorJSON(job->result.description) + "\n\n");
+                    }
+                    else {
+                        JSONEncoder encoder(metrics, false, Precision::Exact, HTTP_SERVER_DEFAULT_DIGITS);
+
+                        event = make_shared<string>(su::format("id: {}\nevent: sweep\ndata: ", job->id));
+                        encoder.encode(*event, *job, false);
+                        *event += "\n\n";
+                    }
+                }
+                write(socketId, event);
+            }
+            if (job->result) {
+                subscription.resumeAt = DateTime::monotonicMilliseconds() + HTTP_SERVER_SUBSCRIPTION_RETRY_MS;
+                return;
+            }
+            sweepSubscription(job->spec, subscription);
+        }
+
+        // WebSocket: after the handshake the client sends text commands with the same parameters as
+        // /litevna (`start=..&step=..&points=..`) to subscribe, or `stop`. Every sweep of the
+        // subscription is sent as one binary frame (see `BinaryEncoder`).
+        void onWebSocketUpgrade(uint64_t socketId, unordered_map<string, string>& headers, unordered_map<string, string> params) {
+            auto key = headers.find("sec-websocket-key");
+            vector<string> connection = su::split(su::toLower(headers["connection"]), ',', true);
+
+            if (su::toLower(headers["upgrade"]) != "websocket" || find(connection.begin(), connection.end(), "upgrade") == connection.end() ||
+                key == headers.end() || key->second.size() == 0) {
+                write(socketId, "HTTP/1.1 426 Upgrade Required\r\nUpgrade: websocket\r\nContent-Length: 16\r\n\r\nUpgrade Required");
+                return;
+            }
+            // The only version of RFC 6455, the client may retry with it (4.2.2)
+            if (headers["sec-websocket-version"] != "13") {
+                write(socketId, "HTTP/1.1 426 Upgrade Required\r\nUpgrade: websocket\r\nSec-WebSocket-Version: 13\r\nContent-Length: 16\r\n\r\nUpgrade Required");
+                return;
+            }
+            write(socketId, su::format("HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Accept: {}\r\n\r\n",
+                WebSocket::acceptKey(key->second)));
+
+            webSockets[socketId] = WebSocketClient();
+
+            LOGGER(HTTPServer, "WebSocket opened (socket_id={})", socketId);
+
+            if (params.size() > 0) {
+                onWebSocketCommand(socketId, params);
+            }
+        }
+
+        void onWebSocketRead(uint64_t socketId, WebSocketClient& client, const string& received) {
+            client.buffer += received;
+
+            while (!client.closing) {
+                WebSocketFrame frame;
+                size_t consumed = 0;
+                Result result = WebSocket::decodeFrame(client.buffer, HTTP_SERVER_WEBSOCKET_MAX_MESSAGE, frame, &consumed);
+
+                if (result) {
+                    LOGGER(HTTPServer, "WebSocket error (socket_id={}): {}", socketId, result.toLog());
+                    closeWebSocket(socketId, client, result.code == "websocket_too_big" ? WEBSOCKET_CLOSE_TOO_BIG : WEBSOCKET_CLOSE_PROTOCOL);
+                    return;
+                }
+                if (consumed == 0) {
+                    return;
+                }
+                client.buffer.erase(0, consumed);
+
+                switch (frame.opcode) {
+                    case WEBSOCKET_OPCODE_PING:
+                        write(socketId, WebSocket::encodeFrame(WEBSOCKET_OPCODE_PONG, frame.payload));
+                        break;
+
+                    case WEBSOCKET_OPCODE_PONG:
+                        break;
+
+                    case WEBSOCKET_OPCODE_CLOSE:
+                        closeWebSocket(socketId, client, WEBSOCKET_CLOSE_NORMAL);
+                        return;
+
+                    case WEBSOCKET_OPCODE_TEXT:
+                    case WEBSOCKET_OPCODE_BINARY:
+                    case WEBSOCKET_OPCODE_CONTINUATION:
+                        // A new message while one is fragmented, or a continuation of nothing
+                        if (client.fragmented == (frame.opcode != WEBSOCKET_OPCODE_CONTINUATION)) {
+                            LOGGER(HTTPServer, "WebSocket error (socket_id={}): unexpected {} frame", socketId,
+                                frame.opcode == WEBSOCKET_OPCODE_CONTINUATION ? "continuation" : "data");
+                            closeWebSocket(socketId, client, WEBSOCKET_CLOSE_PROTOCOL);
+                            return;
+                        }
+                        client.fragmented = !frame.fin;
+                        client.message += frame.payload;
+
+                        if (client.message.size() > HTTP_SERVER_WEBSOCKET_MAX_MESSAGE) {
+                            closeWebSocket(socketId, client, WEBSOCKET_CLOSE_TOO_BIG);
+                            return;
+                        }
+                        if (frame.fin) {
+                            LOGGER(HTTPServer, "WebSocket command (socket_id={}): {}", socketId, client.message);
+
+                            if (su::trim(client.message) == "stop") {
+                                unsubscribe(socketId);
+                                write(socketId, WebSocket::encodeFrame(WEBSOCKET_OPCODE_TEXT, R"({"stopped": true})"));
+                            }
+                            else {
+                                onWebSocketCommand(socketId, parseParams(su::trim(client.message)));
+                            }
+                            client.message.clear();
+                        }
+                        break;
+
+                    default:
+                        closeWebSocket(socketId, client, WEBSOCKET_CLOSE_PROTOCOL);
+                        return;
+                }
+            }
+        }
+
+        // Changes the subscription of a WebSocket without reconnecting
+        void onWebSocketCommand(uint64_t socketId, unordered_map<string, string> params) {
+            SweepSpec spec;
+            string error = parseSpec(params, spec);
+
+            SampleFormat sample = SampleFormat::Float32;
+
+            if (error.size() == 0) {
+                error = parseSample(params, sample);
+            }
+            if (error.size() > 0) {
+                write(socketId, WebSocket::encodeFrame(WEBSOCKET_OPCODE_TEXT, error));
+                return;
+            }
+            webSockets[socketId].encoder = make_shared<BinaryEncoder>(sample);
+            unsubscribe(socketId);
+            write(socketId, WebSocket::encodeFrame(WEBSOCKET_OPCODE_TEXT,
+                su::format(R"({"subscribed": {"start": {}, "step": {}, "points": {}}})", spec.start, spec.step, spec.points)));
+            subscribe(socketId, spec);
+        }
+
+        // The client should close the tcp connection after receiving the close frame. The server closes
+        // it once the frame is sent, or after HTTP_SERVER_WEBSOCKET_CLOSE_MS if it could not be sent.
+        void closeWebSocket(uint64_t socketId, WebSocketClient& client, uint16_t code) {
+            unsubscribe(socketId);
+            client.closing = true;
+            client.closeAt = DateTime::monotonicMilliseconds() + HTTP_SERVER_WEBSOCKET_CLOSE_MS;
+            client.buffer.clear();
+            client.message.clear();
+
+            string* data = new string(WebSocket::encodeClose(code));
+
+            // The socket cannot be closed while it is writing, `closeWebSockets` does it
+            socket->write(socketId, data->data(), data->size(), data, [this](Result result, uint64_t socketId, void* customData) {
+                delete (string*)customData;
+                auto webSocket = webSockets.find(socketId);
+
+                if (!result && webSocket != webSockets.end()) {
+                    webSocket->second.closeAt = 0;
+                }
+            });
+        }
+
+        void closeWebSockets() {
+            vector<uint64_t> socketIds;
+            uint64_t now = 0;
+
+            for (auto& it : webSockets) {
+                if (!it.second.closing) {
+                    continue;
+                }
+                if (now == 0) {
+                    now = DateTime::monotonicMilliseconds();
+                }
+                if (it.second.closeAt <= now) {
+                    socketIds.push_back(it.first);
+                }
+            }
+            for (uint64_t socketId : socketIds) {
+                LOGGER(HTTPServer, "WebSocket closed (socket_id={})", socketId);
+                socket->close(socketId);
+            }
+        }
+
+        void onClose(uint64_t socketId) {
+            unsubscribe(socketId);
+            webSockets.erase(socketId);
+
+            auto it = pendingSweeps.find(socketId);
+
+            if (it == pendingSweeps.end()) {
+                return;
+            }
+            vector<SweepWaiter>& waiters = it->second->waiters;
+
+            waiters.erase(remove_if(waiters.begin(), waiters.end(), [socketId](const SweepWaiter& waiter) {
+                return waiter.socketId == socketId;
+            }), waiters.end());
+            pendingSweeps.erase(it);
+        }
+
+        // Sends the points decoded so far to streaming clients of running sweeps
+        void onSweepProgress() {
+            for (auto& running : runningSweeps) {
+                SweepJob& job = *running.second;
+
+                if (!job.streaming) {
+                    continue;
+                }
+                size_t contiguousPoints = job.contiguousPoints.load(memory_order_acquire);
+
+                for (SweepWaiter& waiter : job.waiters) {
+                    if (waiter.streaming && waiter.sentPoints < contiguousPoints) {
+                        writeStreamPoints(waiter, job, contiguousPoints);
+                    }
+                }
+            }
+        }
+
+        void onSweepCompleted(shared_ptr<SweepJob> job) {
+            auto capture = captures.find(job->id);
+
+            if (capture != captures.end()) {
+                onCaptureCompleted(job, capture->second);
+                captures.erase(capture);
+                return;
+            }
+            runningSweeps.erase(job->spec);
+            sweepCache->insert(job);
+
+            // Encoded once for every variant (encoder and options) requested by the waiters
+            unordered_map<string, shared_ptr<string>> encoded;
+
+            for (SweepWaiter& waiter : job->waiters) {
+                pendingSweeps.erase(waiter.socketId);
+
+                if (waiter.streaming) {
+                    if (!job->result) {
+                        writeStreamPoints(waiter, *job, job->spec.points);
+                    }
+                    writeStreamEnd(waiter, *job, false);
+                    continue;
+                }
+                if (job->result) {
+                    writeJSON(waiter.socketId, "200 OK", errorJSON(job->result.description));
+                    continue;
+                }
+                if (waiter.tdr) {
+                    writeJSON(waiter.socketId, "200 OK", toTDRJSON(*job, waiter, false));
+                    continue;
+                }
+                shared_ptr<string>& body = encoded[waiter.encoder->variant()];
+
+                if (!body) {
+                    body = make_shared<string>();
+                    waiter.encoder->encode(*body, *job, false);
+                }
+                writeBody(waiter.socketId, waiter.encoder->contentType(), body);
+            }
+            publish(job);
+        }
+
+        // Host calibrated jobs, always pinned to the calibrated device, carry the error terms of their grid.
+        // Fails if the calibration was replaced by one that does not cover the grid, subscriptions then
+        // retry later.
+        bool submit(shared_ptr<SweepJob> job) {
+            if (job->spec.calibration == SweepCalibration::Host) {
+                job->errorTerms = calibration->getTerms((size_t)job->spec.device, job->spec.start, job->spec.step, job->spec.points);
+
+                if (!job->errorTerms) {
+                    return false;
+                }
+            }
+            return devicePool->submit(job);
+        }
+
+        // Error descriptions may quote parameters or device replies, so they are escaped
+        static string errorJSON(const string& description) {
+            string json = R"({"error": )";
+            JSONWriter::appendString(json, description);
+            json += '}';
+
+            return json;
+        }
+
+        void writeJSON(uint64_t socketId, const char* status, const string& json) {
+            write(socketId, su::format("HTTP/1.1 {}\r\nConnection: close\r\nContent-Type: application/json\r\nContent-Length: {}\r\n\r\n{}", status, json.size(), json));
+        }
+
+        void writeSweep(uint64_t socketId, SweepEncoder& encoder, const SweepJob& job, bool cached) {
+            shared_ptr<string> body = make_shared<string>();
+
+            encoder.encode(*body, job, cached);
+            writeBody(socketId, encoder.contentType(), body);
+        }
+
+        // The headers and the body are written separately, so the encoded body is never copied
+        void writeBody(uint64_t socketId, const char* contentType, shared_ptr<string> body) {
+            write(socketId, su::format("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Type: {}\r\nContent-Length: {}\r\n\r\n", contentType, body->size()));
+            write(socketId, body);
+        }
+
+        // Streaming responses use chunked transfer encoding, each chunk carries the points decoded
+        // since the previous one, so memory per response does not grow with the number of points.
+        // The encoder writes each chunk in place into the buffer handed to the socket.
+        void writeStreamBegin(const SweepWaiter& waiter, const SweepJob& job) {
+            string data = su::format("HTTP/1.1 200 OK\r\nConnection: close\r\nContent-Type: {}\r\nTransfer-Encoding: chunked\r\n\r\n", waiter.encoder->contentType());
+            size_t chunk = openChunk(data);
+
+            waiter.encoder->begin(data, job);
+            closeChunk(data, chunk);
+            write(waiter.socketId, move(data));
+        }
+
+        void writeStreamPoints(SweepWaiter& waiter, const SweepJob& job, size_t contiguousPoints) {
+            while (waiter.sentPoints < contiguousPoints) {
+                size_t end = min(contiguousPoints, waiter.sentPoints + HTTP_SERVER_STREAM_POINTS);
+                string data;
+                size_t chunk = openChunk(data);
+
+                waiter.encoder->points(data, job, waiter.sentPoints, end);
+                closeChunk(data, chunk);
+                waiter.sentPoints = end;
+
+                if (data.size() > 0) {
+                    write(waiter.socketId, move(data));
+                }
+            }
+        }
+
+        void writeStreamEnd(const SweepWaiter& waiter, const SweepJob& job, bool cached) {
+            string data;
+            size_t chunk = openChunk(data);
+
+            if (job.result) {
+                waiter.encoder->fail(data, job.result.description);
+            }
+            else {
+                waiter.encoder->end(data, job, cached);
+            }
+            closeChunk(data, chunk);
+            data += "0\r\n\r\n";
+            write(waiter.socketId, move(data));
+        }
+
+        // Reserves the size line of a chunk at the end of `data`, the chunk data is appended after it
+        static size_t openChunk(string& data) {
+            size_t offset = data.size();
+            data += "00000000\r\n";
+
+            return offset;
+        }
+
+        // Writes the size of the chunk opened at `offset`. An empty chunk is removed, it would end the response.
+        static void closeChunk(string& data, size_t offset) {
+            size_t size = data.size() - offset - HTTP_SERVER_CHUNK_HEADER_SIZE;
+
+            if (size == 0) {
+                data.resize(offset);
+                return;
+            }
+            // Chunks hold at most HTTP_SERVER_STREAM_POINTS points, far below 8 hex digits
+            for (size_t n = 8; n > 0; n--) {
+                data[offset + n - 1] = "0123456789abcdef"[size & 0x0F];
+                size >>= 4;
+            }
+            data += "\r\n";
+        }
+
+        // Writes a buffer shared by several sockets, it is released after the last write finishes
+        void write(uint64_t socketId, shared_ptr<string> text) {
+            LOGGER(HTTPServer, "Sending shared response (socket_id={}): {}\n", socketId, *text);
+
+            shared_ptr<string>* data = new shared_ptr<string>(text);
+
+            socket->write(socketId, text->data(), text->size(), data, [](Result result, uint64_t socketId, void* customData) {
+                delete (shared_ptr<string>*)customData;
+            });
+        }
+
+        // The buffer is moved to the socket and released after the write finishes
+        void write(uint64_t socketId, string text) {
             LOGGER(HTTPServer, "Sending response (socket_id={}): {}\n", socketId, text);
 
-            char* data = new char[text.size()];
-            memcpy(data, text.data(), text.size());
+            string* data = new string(move(text));
 
-            socket->write(socketId, data, text.size(), data, [](Result result, uint64_t socketId, void* customData) {
-                delete[](char*)customData;
+            socket->write(socketId, data->data(), data->size(), data, [](Result result, uint64_t socketId, void* customData) {
+                delete (string*)customData;
             });
         }
 
-        string execute(unordered_map<string, string> params) {
+        // Validates the request parameters. Returns an error JSON, or an empty string on success.
+        string parseSpec(const unordered_map<string, string>& params, SweepSpec& spec) {
             auto startParam = params.find("start");
 
             if (startParam == params.end()) {
@@ -158,35 +938,321 @@ namespace litevnaserver {
             if (pointsParam == params.end()) {
                 return R"({"error": "missing 'points' parameter"})";
             }
-            uint16_t points = su::atou<uint16_t>(pointsParam->second.data(), pointsParam->second.size(), &error);
+            uint32_t points = su::atou<uint32_t>(pointsParam->second.data(), pointsParam->second.size(), &error);
 
-            if (error || points == 0) {
+            if (error || points == 0 || points > HTTP_SERVER_MAX_POINTS) {
                 return R"({"error": "invalid 'points' parameter"})";
             }
-            ScanValues values;
-            Result result = liteVNA->scan(start, step, points, values);
+            uint16_t average = 1;
+            auto averageParam = params.find("avg");
+
+            if (averageParam != params.end()) {
+                average = su::atou<uint16_t>(averageParam->second.data(), averageParam->second.size(), &error);
+
+                if (error || average == 0 || average > HTTP_SERVER_MAX_AVERAGE) {
+                    return R"({"error": "invalid 'avg' parameter"})";
+                }
+            }
+            spec.start = start;
+            spec.step = step;
+            spec.points = points;
+            spec.average = average;
+            spec.device = -1;
+            auto deviceParam = params.find("device");
+
+            if (deviceParam != params.end()) {
+                size_t device = su::atou<size_t>(deviceParam->second.data(), deviceParam->second.size(), &error);
+
+                if (error || device >= devicePool->size()) {
+                    return R"({"error": "invalid 'device' parameter"})";
+                }
+                spec.device = (int)device;
+            }
+            spec.calibration = SweepCalibration::Device;
+            spec.calibrationVersion = 0;
+            auto calibrationParam = params.find("cal");
+
+            if (calibrationParam != params.end()) {
+                if (calibrationParam->second == "host") {
+                    size_t device = 0;
+                    string deviceError = parseCalibrationDevice(params, device);
+
+                    if (deviceError.size() > 0) {
+                        return deviceError;
+                    }
+                    if (!calibration->isComplete(device)) {
+                        return R"({"error": "host calibration is not complete"})";
+                    }
+                    if (!calibration->getTerms(device, start, step, points)) {
+                        return R"({"error": "host calibration does not cover the requested frequencies"})";
+                    }
+                    spec.device = (int)device;
+                    spec.calibration = SweepCalibration::Host;
+                    spec.calibrationVersion = calibration->getVersion(device);
+                }
+                else if (calibrationParam->second == "raw") {
+                    spec.calibration = SweepCalibration::Raw;
+                }
+                else if (calibrationParam->second != "device") {
+                    return R"({"error": "invalid 'cal' parameter"})";
+                }
+            }
+
+            return "";
+        }
+
+        // Device of a host calibration. Each device has its own, so `device` is required when there are several.
+        // Returns an error JSON, or an empty string on success.
+        string parseCalibrationDevice(const unordered_map<string, string>& params, size_t& device) {
+            auto deviceParam = params.find("device");
+
+            if (deviceParam == params.end()) {
+                if (devicePool->size() > 1) {
+                    return R"({"error": "missing 'device' parameter, each device has its own host calibration"})";
+                }
+                device = 0;
+                return "";
+            }
+            bool error;
+            device = su::atou<size_t>(deviceParam->second.data(), deviceParam->second.size(), &error);
+
+            if (error || device >= devicePool->size()) {
+                return R"({"error": "invalid 'device' parameter"})";
+            }
+            return "";
+        }
+
+        // Encoder of the sweep endpoints, chosen by the `format` parameter, or else by the first supported
+        // media type of the Accept header (json by default). Returns an error JSON, or an empty string on success.
+        string parseOutput(const unordered_map<string, string>& params, const string& accept, shared_ptr<SweepEncoder>& encoder) {
+            auto deviation = params.find("std");
+            bool withDeviation = deviation != params.end() && deviation->second == "1";
+            Precision precision;
+
+            auto precisionParam = params.find("precision");
+
+            if (precisionParam == params.end() || precisionParam->second == "exact") {
+                precision = Precision::Exact;
+            }
+            else if (precisionParam->second == "fast") {
+                precision = Precision::Fast;
+            }
+            else {
+                return R"({"error": "invalid 'precision' parameter"})";
+            }
+            int digits = HTTP_SERVER_DEFAULT_DIGITS;
+            string error = parseDigits(params, digits);
+
+            if (error.size() > 0) {
+                return error;
+            }
+            SampleFormat sample = SampleFormat::Float32;
+            error = parseSample(params, sample);
+
+            if (error.size() > 0) {
+                return error;
+            }
+            TouchstoneFormat touchstone;
+            auto touchstoneParam = params.find("touchstone");
+
+            if (touchstoneParam == params.end() || touchstoneParam->second == "ma") {
+                touchstone = TouchstoneFormat::MA;
+            }
+            else if (touchstoneParam->second == "ri") {
+                touchstone = TouchstoneFormat::RI;
+            }
+            else if (touchstoneParam->second == "db") {
+                touchstone = TouchstoneFormat::DB;
+            }
+            else {
+                return R"({"error": "invalid 'touchstone' parameter"})";
+            }
+            auto formatParam = params.find("format");
+            string format = formatParam != params.end() ? formatParam->second : negotiateFormat(accept);
+
+            if (format == "json") {
+                encoder = make_shared<JSONEncoder>(metrics, withDeviation, precision, digits);
+            }
+            else if (format == "bin") {
+                encoder = make_shared<BinaryEncoder>(sample);
+            }
+            else if (format == "cbor") {
+                encoder = make_shared<CBOREncoder>(metrics, withDeviation, precision);
+            }
+            else if (format == "csv") {
+                encoder = make_shared<CSVEncoder>(withDeviation);
+            }
+            else if (format == "s2p") {
+                encoder = make_shared<TouchstoneEncoder>(touchstone);
+            }
+            else {
+                return R"({"error": "invalid 'format' parameter"})";
+            }
+            return "";
+        }
+
+        // Media type parameters (q values included) are ignored, the order of the header decides
+        static string negotiateFormat(const string& accept) {
+            for (const string& range : su::split(accept, ',', false)) {
+                string type = su::toLower(su::trim(range.substr(0, range.find(';'))));
+
+                if (type == "application/json" || type == "*/*" || type == "application/*") {
+                    return "json";
+                }
+                if (type == "application/octet-stream") {
+                    return "bin";
+                }
+                if (type == "application/cbor") {
+                    return "cbor";
+                }
+                if (type == "text/csv") {
+                    return "csv";
+                }
+                if (type == "application/x-touchstone") {
+                    return "s2p";
+                }
+            }
+            return "json";
+        }
+
+        // Significant digits of JSON numbers, 0 for the shortest round trip. Returns an error JSON, or an
+        // empty string on success.
+        static string parseDigits(const unordered_map<string, string>& params, int& digits) {
+            auto digitsParam = params.find("digits");
+
+            if (digitsParam != params.end()) {
+                bool error;
+                uint32_t value = su::atou<uint32_t>(digitsParam->second.data(), digitsParam->second.size(), &error);
+
+                if (error || value > JSON_WRITER_MAX_DIGITS) {
+                    return R"({"error": "invalid 'digits' parameter"})";
+                }
+                digits = (int)value;
+            }
+            return "";
+        }
+
+        // Sample format of binary sweeps. Returns an error JSON, or an empty string on success.
+        static string parseSample(const unordered_map<string, string>& params, SampleFormat& sample) {
+            auto sampleParam = params.find("sample");
+
+            if (sampleParam == params.end() || sampleParam->second == "float32") {
+                sample = SampleFormat::Float32;
+            }
+            else if (sampleParam->second == "float16") {
+                sample = SampleFormat::Float16;
+            }
+            else if (sampleParam->second == "int16") {
+                sample = SampleFormat::Int16;
+            }
+            else {
+                return R"({"error": "invalid 'sample' parameter"})";
+            }
+            return "";
+        }
+
+        // Parameters of /litevna/tdr. Returns an error JSON, or an empty string on success.
+        static string parseTDR(const unordered_map<string, string>& params, const SweepSpec& spec, SweepWaiter& waiter) {
+            TDRSpec& tdrSpec = waiter.tdrSpec;
+            waiter.tdr = true;
+
+            auto window = params.find("window");
+
+            if (window == params.end() || window->second == "kaiser") {
+                tdrSpec.window = TDRWindow::Kaiser;
+            }
+            else if (window->second == "hann") {
+                tdrSpec.window = TDRWindow::Hann;
+            }
+            else if (window->second == "none") {
+                tdrSpec.window = TDRWindow::None;
+            }
+            else {
+                return R"({"error": "invalid 'window' parameter"})";
+            }
+            auto beta = params.find("beta");
+
+            if (beta != params.end() && (!parseDouble(beta->second, tdrSpec.beta) || tdrSpec.beta < 0 || tdrSpec.beta > 50)) {
+                return R"({"error": "invalid 'beta' parameter"})";
+            }
+            auto response = params.find("response");
+
+            if (response == params.end() || response->second == "impulse") {
+                tdrSpec.response = TDRResponse::Impulse;
+            }
+            else if (response->second == "step") {
+                tdrSpec.response = TDRResponse::Step;
+            }
+            else {
+                return R"({"error": "invalid 'response' parameter"})";
+            }
+            auto velocityFactor = params.find("vf");
+
+            if (velocityFactor != params.end() && (!parseDouble(velocityFactor->second, tdrSpec.velocityFactor) || tdrSpec.velocityFactor <= 0 || tdrSpec.velocityFactor > 1)) {
+                return R"({"error": "invalid 'vf' parameter"})";
+            }
+            auto bins = params.find("bins");
+
+            if (bins != params.end()) {
+                bool error;
+                tdrSpec.bins = su::atou<size_t>(bins->second.data(), bins->second.size(), &error);
+
+                if (error || tdrSpec.bins == 0 || tdrSpec.bins > TDR_MAX_BINS) {
+                    return R"({"error": "invalid 'bins' parameter"})";
+                }
+            }
+            auto distance = params.find("distance");
+
+            if (distance != params.end() && (!parseDouble(distance->second, tdrSpec.distance) || tdrSpec.distance <= 0)) {
+                return R"({"error": "invalid 'distance' parameter"})";
+            }
+            waiter.tdrDigits = HTTP_SERVER_DEFAULT_DIGITS;
+            string error = parseDigits(params, waiter.tdrDigits);
+
+            if (error.size() > 0) {
+                return error;
+            }
+            Result result = TDR::validate(spec.start, spec.step, spec.points, tdrSpec);
 
             if (result) {
-                return su::format(R"("{error": "{}"})", result.description);
+                return errorJSON(result.description);
             }
-            string json = R"({"result":[)";
-            bool addComma = false;
-            uint64_t freq = start;
+            return "";
+        }
+
+        static bool parseDouble(const string& text, double& value) {
+            char* end = nullptr;
+            value = strtod(text.data(), &end);
 
-            for (size_t n = 0; n < points; n++) {
-                complex<float> s11 = values.channel0In[n];
-                complex<float> s21 = values.channel1In[n];
+            return text.size() > 0 && end == text.data() + text.size() && isfinite(value);
+        }
 
-                if (addComma) {
+        string toTDRJSON(const SweepJob& job, const SweepWaiter& waiter, bool cached) {
+            Result result = tdr.compute(job.values, job.spec.start, job.spec.step, job.spec.points, waiter.tdrSpec);
+
+            if (result) {
+                return errorJSON(result.description);
+            }
+            string json;
+            // Every bin fits in 64 bytes
+            json.reserve(64 + tdr.response.size() * 64);
+            JSONWriter::appendLiteral(json, R"({"result":[)");
+
+            for (size_t n = 0; n < tdr.response.size(); n++) {
+                if (n > 0) {
                     json += ',';
                 }
-                json += su::format(R"({"freq": {}, "s11": {"log_mag": {}, "phase": {}, "swr": {}},"s21": {"log_mag": {}, "phase": {}}})",
-                    freq, LiteVNA::logMag(s11), LiteVNA::phase(s11), LiteVNA::swr(s11), LiteVNA::logMag(s21), LiteVNA::phase(s21));
-
-                freq += step;
-                addComma = true;
+                JSONWriter::appendLiteral(json, R"({"distance": )");
+                JSONWriter::appendFloat(json, (float)(n * tdr.resolution), waiter.tdrDigits);
+                JSONWriter::appendLiteral(json, R"(, "value": )");
+                JSONWriter::appendFloat(json, tdr.response[n], waiter.tdrDigits);
+                json += '}';
             }
-            json += "]}";
+            JSONWriter::appendLiteral(json, R"(],"resolution":)");
+            JSONWriter::appendFloat(json, (float)tdr.resolution, waiter.tdrDigits);
+            JSONWriter::appendLiteral(json, R"(,"lowpass":)");
+            JSONWriter::appendBool(json, TDR::isLowpass(job.spec.start, job.spec.step));
+            JSONEncoder::appendCached(json, cached);
 
             return json;
         }
@@ -4,60 +4,97 @@
 #pragma once
 
 #include <complex>
+#include <functional>
 #include <thread>
 
+#include "lib/RingBuffer.h"
 #include "lib/SerialPort.h"
+#include "lib/SerialReplay.h"
+#include "FifoDecoder.h"
+#include "LiteVNAProtocol.h"
 
-#define LITEVNA_CLEAR_FIFO 0,0,0,0,0,0,0,0
-
-#define LITEVNA_CMD_INDICATE  0x0D
-#define LITEVNA_CMD_READ1     0x10
-#define LITEVNA_CMD_READ2     0x11
-#define LITEVNA_CMD_READ4     0x12
-#define LITEVNA_CMD_READ_FIFO 0x18
-#define LITEVNA_CMD_WRITE1    0x20
-#define LITEVNA_CMD_WRITE2    0x21
-#define LITEVNA_CMD_WRITE4    0x22
-#define LITEVNA_CMD_WRITE8    0x23
-
-#define LITEVNA_REG_SWEEP_START           0x00
-#define LITEVNA_REG_SWEEP_STEP            0x10
-#define LITEVNA_REG_SWEEP_POINTS          0x20
-#define LITEVNA_REG_VALUES_PER_FREQUENCY  0x22
-#define LITEVNA_REG_SAMPLES_MODE          0x26
-#define LITEVNA_REG_READ_FIFO             0x30
-#define LITEVNA_REG_DEVICE_VARIANT        0xF0
-#define LITEVNA_REG_PROTOCOL_VERSION      0xF1
-
-#define LITEVNA_SEND_ALL_POINTS           0x00
-
-#define LITEVNA_SAMPLES_MODE_APP_CALIBRATION 0x01
-#define LITEVNA_SAMPLES_MODE_LEAVE 0x02
-#define LITEVNA_SAMPLES_MODE_DEVICE_CALIBRATION 0x03
+#define LITEVNA_RESPONSE_TIMEOUT_MS  1000
+#define LITEVNA_FIFO_BUFFER_SIZE     (64 * 1024)
+#define LITEVNA_FIFO_CHUNK_MAX       255
+#define LITEVNA_FIFO_CHUNKS_IN_FLIGHT 2
 
 #define LITEVNA_PI        3.141592654f
 #define LITEVNA_VSWR_MAX  100000
 
 namespace litevnaserver {
-#pragma pack(push, 1)
-    struct LiteVNAFifoData
-    {
-        int32_t  channel0OutRe;
-        int32_t  channel0OutIm;
-        int32_t  channel0InRe;
-        int32_t  channel0InIm;
-        int32_t  channel1InRe;
-        int32_t  channel1InIm;
-        uint16_t freqIndex;
-        uint8_t  reserved[5];
-        uint8_t  checksum;
+
+    // Part of a sweep programmed into the device at once, `offset` is its first point in the sweep
+    struct ScanSegment {
+        uint64_t start;
+        uint32_t offset;
+        uint16_t points;
     };
-#pragma pack(pop)
 
     struct ScanValues {
         vector<complex<float>> channel0Out;
         vector<complex<float>> channel0In;
         vector<complex<float>> channel1In;
+
+        // Sample standard deviation of the values averaged for each point (empty without averaging)
+        vector<float> channel0InDeviation;
+        vector<float> channel1InDeviation;
+    };
+
+    // Sequence of LiteVNA commands built in one buffer, so it reaches the device with a single serial
+    // write (and usually a single USB transfer) instead of one write per command
+    class LiteVNACommands {
+    public:
+        void clear() {
+            buffer.clear();
+        }
+
+        bool empty() const {
+            return buffer.empty();
+        }
+
+        const uint8_t* data() const {
+            return buffer.data();
+        }
+
+        size_t size() const {
+            return buffer.size();
+        }
+
+        LiteVNACommands& clearFifo() {
+            buffer.insert(buffer.end(), { LITEVNA_CLEAR_FIFO });
+            return *this;
+        }
+
+        LiteVNACommands& write1(uint8_t reg, uint8_t value) {
+            return write(LITEVNA_CMD_WRITE1, reg, value, 1);
+        }
+
+        LiteVNACommands& write2(uint8_t reg, uint16_t value) {
+            return write(LITEVNA_CMD_WRITE2, reg, value, 2);
+        }
+
+        LiteVNACommands& write8(uint8_t reg, uint64_t value) {
+            return write(LITEVNA_CMD_WRITE8, reg, value, 8);
+        }
+
+        LiteVNACommands& readFifo(uint8_t total) {
+            buffer.insert(buffer.end(), { LITEVNA_CMD_READ_FIFO, LITEVNA_REG_READ_FIFO, total });
+            return *this;
+        }
+
+    private:
+        vector<uint8_t> buffer;
+
+        // Values are little endian
+        LiteVNACommands& write(uint8_t cmd, uint8_t reg, uint64_t value, size_t size) {
+            buffer.push_back(cmd);
+            buffer.push_back(reg);
+
+            for (size_t n = 0; n < size; n++) {
+                buffer.push_back((uint8_t)(value >> (n * 8)));
+            }
+            return *this;
+        }
     };
 
     class LiteVNA {
@@ -71,17 +108,15 @@ namespace litevnaserver {
         ~LiteVNA() = default;
 
         Result initialize() {
-            Result result = serial->open(config->comPort, BaudRate::_115200, Parity::None, 8, StopBits::One);
+            Result result = serial->open(comPort, BaudRate::_115200, Parity::None, 8, StopBits::One);
 
             if (result) {
                 return result;
             }
-            result = clearFifo();
+            commands.clear();
+            commands.clearFifo().write1(LITEVNA_REG_SAMPLES_MODE, LITEVNA_SAMPLES_MODE_LEAVE);
 
-            if (result) {
-                return result;
-            }
-            result = leaveDataMode();
+            result = sendCommands("Sending `Clear Fifo`, `Leave data mode`");
 
             if (result) {
                 return result;
@@ -98,7 +133,7 @@ namespace litevnaserver {
             }
             result = checkProtocolVersion();
 
-            LOGGER(Info, "Found LiteVNA at com port {}", config->comPort);
+            LOGGER(Info, "Found LiteVNA at com port {}", comPort);
             return result;
         }
 
@@ -111,110 +146,82 @@ namespace litevnaserver {
             config = _config;
         }
 
-        // 3. Functionalities
-        Result scan(uint64_t start, uint64_t step, uint16_t points, ScanValues& values) {
-            LOGGER(LiteVNA, "Scanning start={}, step={}, points={}", start, step, points);
-
-            Result result = clearFifo();
+        void setComPort(const string& _comPort) {
+            comPort = _comPort;
+        }
 
-            if (result) {
-                return result;
-            }
-            result = enterDataMode();
+        // SerialPort unless replaced, e.g. by a SerialRecorder or a SerialReplay
+        void setSerial(unique_ptr<SerialTransport> _serial) {
+            serial = move(_serial);
+        }
 
-            if (result) {
-                return result;
-            }
-            result = sendCmdWrite8("Sending `Sweep start value`", LITEVNA_REG_SWEEP_START, start);
+        // 3. Functionalities
+        typedef function<void(size_t contiguousPoints)> ScanProgressCallback;
 
-            if (result) {
-                return result;
-            }
-            result = sendCmdWrite8("Sending `Sweep step value`", LITEVNA_REG_SWEEP_STEP, step);
+        // The device measures `average` values per frequency, they are averaged in a single pass.
+        // Sweeps larger than `Config::segmentPoints` are split in segments: the device processes commands
+        // in order, so the next segment is programmed right after the last Fifo request of the current
+        // one and starts measuring while the current one is still being transferred.
+        // Commands are batched: entering data mode, programming the first segment and the first Fifo
+        // requests go out in a single write, as do each later segment and its requests.
+        // `samplesMode` is LITEVNA_SAMPLES_MODE_DEVICE_CALIBRATION for values corrected by the device, or
+        // LITEVNA_SAMPLES_MODE_APP_CALIBRATION for raw values.
+        // `progress` (optional) receives the number of points already decoded from index 0 onwards.
+        Result scan(uint64_t start, uint64_t step, uint32_t points, uint16_t average, uint8_t samplesMode, ScanValues& values, const ScanProgressCallback& progress = nullptr) {
+            LOGGER(LiteVNA, "Scanning start={}, step={}, points={}, average={}, samplesMode={}", start, step, points, average, (int)samplesMode);
 
-            if (result) {
-                return result;
-            }
-            result = sendCmdWrite2("Sending `Sweep points value`", LITEVNA_REG_SWEEP_POINTS, points);
+            vector<ScanSegment> segments = planSegments(start, step, points, config->segmentPoints);
 
-            if (result) {
-                return result;
-            }
-            result = sendCmdWrite2("Sending `Values per frequency`", LITEVNA_REG_VALUES_PER_FREQUENCY, 1);
+            // Drops anything left by a previous sweep that timed out
+            Result result = serial->purge();
 
             if (result) {
                 return result;
             }
-            this_thread::sleep_for(chrono::milliseconds(50));
-
-            result = readFifo();
+            // Sent along with the first Fifo requests of segment 0
+            commands.clear();
+            commands.write1(LITEVNA_REG_SAMPLES_MODE, samplesMode);
+            appendSweep(segments[0], step, average);
 
-            if (result) {
-                return result;
-            }
             values.channel0Out.resize(points);
             values.channel0In.resize(points);
             values.channel1In.resize(points);
+            values.channel0InDeviation.assign(average > 1 ? points : 0, 0.0f);
+            values.channel1InDeviation.assign(average > 1 ? points : 0, 0.0f);
 
-            size_t count = 0;
-
-            while (count < points) {
-                uint8_t buffer[sizeof(LiteVNAFifoData)];
-                size_t bufferPos = 0;
-                size_t totalRead = 0;
-                uint64_t start = DateTime::nowMilliseconds();
+            // Bounded wait for the whole sweep, data is drained as soon as it arrives
+            uint64_t deadline = DateTime::monotonicMilliseconds() + config->sweepTimeout + (uint64_t)points * average * config->pointTimeout;
+            size_t contiguous = 0;
+            vector<uint16_t> decoded(points, 0);
 
-                while (bufferPos < sizeof(LiteVNAFifoData)) {
-                    result = serial->read(buffer + bufferPos, sizeof(LiteVNAFifoData) - bufferPos, &totalRead);
+            fifoBuffer.clear();
 
-                    if (result) {
-                        return result;
-                    }
-                    if (totalRead > 0) {
-                        LOGGER(LiteVNA, "Received{}", formatBytes(buffer + bufferPos, totalRead));
-
-                        bufferPos += totalRead;
-                    }
-                    if ((start + 10000) < DateTime::nowMilliseconds()) {
-                        return Result("lite_vna_error", "Timeout reading LiteVNA Fifo data");
-                    }
-                }
-                uint8_t checksum = 0x46;
-                uint8_t* data = buffer;
-                LiteVNAFifoData* fifo = (LiteVNAFifoData*)buffer;
-
-                for (size_t i = 0; i < (sizeof(LiteVNAFifoData) - 1); i++) {
-                    checksum = (checksum ^ ((checksum << 1) | 1u)) ^ data[i];
-                }
+            for (size_t k = 0; k < segments.size(); k++) {
+                result = scanSegment(segments, k, step, average, deadline, values, decoded, contiguous, progress);
 
-                if (checksum != fifo->checksum) {
-                    return Result("lite_vna_error", "Invalid Checksum `{}`", checksum);
+                if (result) {
+                    return result;
                 }
-                complex<float> out0((float)fifo->channel0OutRe, (float)fifo->channel0OutIm);
-                complex<float> in0 = complex<float>((float)fifo->channel0InRe, (float)fifo->channel0InIm) / out0;
-                complex<float> in1 = complex<float>((float)fifo->channel1InRe, (float)fifo->channel1InIm) / out0;
+            }
 
-                if (fifo->freqIndex >= points) {
-                    return Result("lite_vna_error", "Invalid Frequency Index `{}`", fifo->freqIndex);
-                }
-                values.channel0Out[fifo->freqIndex] = out0;
-                values.channel0In[fifo->freqIndex] = in0;
-                values.channel1In[fifo->freqIndex] = in1;
+            commands.clearFifo().write1(LITEVNA_REG_SAMPLES_MODE, LITEVNA_SAMPLES_MODE_LEAVE);
 
-                count++;
-            }
+            return sendCommands("Sending `Clear Fifo`, `Leave data mode`");
+        }
 
-            result = clearFifo();
+        // Splits a sweep in the fewest segments of at most `maxPoints`, all of similar size
+        static vector<ScanSegment> planSegments(uint64_t start, uint64_t step, uint32_t points, uint16_t maxPoints) {
+            size_t count = (points + maxPoints - 1) / maxPoints;
+            vector<ScanSegment> segments;
+            uint32_t offset = 0;
 
-            if (result) {
-                return result;
-            }
-            result = leaveDataMode();
+            for (size_t k = 0; k < count; k++) {
+                uint32_t size = (uint32_t)((points - offset) / (count - k));
 
-            if (result) {
-                return result;
+                segments.push_back(ScanSegment{ start + offset * step, offset, (uint16_t)size });
+                offset += size;
             }
-            return Result::ok();
+            return segments;
         }
 
         static float linear(complex<float> value) {
@@ -243,30 +250,192 @@ namespace litevnaserver {
 
     private:
         Config* config = nullptr;
-        unique_ptr<SerialPort> serial = make_unique<SerialPort>();
+        string comPort;
+        unique_ptr<SerialTransport> serial = make_unique<SerialPort>();
+        RingBuffer fifoBuffer{ LITEVNA_FIFO_BUFFER_SIZE };
+        FifoFrames fifoFrames{ LITEVNA_FIFO_BUFFER_SIZE / sizeof(LiteVNAFifoData) };
+        LiteVNACommands commands;
+
+        // Clears the Fifo and programs the sweep registers for `segment`
+        void appendSweep(const ScanSegment& segment, uint64_t step, uint16_t average) {
+            commands.clearFifo()
+                .write8(LITEVNA_REG_SWEEP_START, segment.start)
+                .write8(LITEVNA_REG_SWEEP_STEP, step)
+                .write2(LITEVNA_REG_SWEEP_POINTS, segment.points)
+                .write2(LITEVNA_REG_VALUES_PER_FREQUENCY, average);
+        }
+
+        // Receives and decodes segment `k`, which is already programmed. Segment `k + 1` is programmed as
+        // soon as every Fifo value of segment `k` has been requested.
+        Result scanSegment(const vector<ScanSegment>& segments, size_t k, uint64_t step, uint16_t average, uint64_t deadline,
+            ScanValues& values, vector<uint16_t>& decoded, size_t& contiguous, const ScanProgressCallback& progress) {
+            const ScanSegment& segment = segments[k];
+            size_t total = (size_t)segment.points * average;
+            size_t count = 0;
+            size_t requested = 0;
+            bool nextSent = k + 1 >= segments.size();
+
+            while (count < total) {
+                requestFifo(total, count, requested);
+
+                if (!nextSent && requested == total) {
+                    appendSweep(segments[k + 1], step, average);
+                    nextSent = true;
+                }
+                Result result = sendCommands("Sending `Sweep`, `Read Fifo`");
+
+                if (result) {
+                    return result;
+                }
+                result = receiveFifo(deadline);
 
-        Result clearFifo() {
-            uint8_t buffer[] = { LITEVNA_CLEAR_FIFO };
+                if (result) {
+                    return result;
+                }
 
-            return write("Sending `Clear Fifo`", buffer, sizeof(buffer));
+                // Decode every complete frame received so far in contiguous batches, the rest belongs to
+                // the next segment
+                while (fifoBuffer.size() >= sizeof(LiteVNAFifoData) && count < total) {
+                    size_t regionSize = 0;
+                    const uint8_t* frames = fifoBuffer.readRegion(&regionSize);
+                    size_t frameCount = min(regionSize / sizeof(LiteVNAFifoData), total - count);
+                    uint8_t wrapped[sizeof(LiteVNAFifoData)];
+
+                    if (frameCount == 0) {
+                        fifoBuffer.peek(wrapped, sizeof(wrapped));
+                        frames = wrapped;
+                        frameCount = 1;
+                    }
+                    result = decodeFifoData(frames, frameCount, segment, average, values, decoded);
+
+                    if (result) {
+                        return result;
+                    }
+                    fifoBuffer.consume(frameCount * sizeof(LiteVNAFifoData));
+                    count += frameCount;
+                }
+                if (progress && contiguous < decoded.size() && decoded[contiguous] == average) {
+                    while (contiguous < decoded.size() && decoded[contiguous] == average) {
+                        contiguous++;
+                    }
+                    progress(contiguous);
+                }
+            }
+            return Result::ok();
         }
 
-        Result enterDataMode() {
-            uint8_t buffer[] = { LITEVNA_CMD_WRITE1, LITEVNA_REG_SAMPLES_MODE, LITEVNA_SAMPLES_MODE_DEVICE_CALIBRATION };
+        // Reads what the serial port has into `fifoBuffer`, waiting until at least one byte arrives
+        Result receiveFifo(uint64_t deadline) {
+            bool first = true;
+
+            while (fifoBuffer.freeSpace() > 0) {
+                size_t regionSize = 0;
+                uint8_t* region = fifoBuffer.writeRegion(&regionSize);
+                size_t totalRead = 0;
+
+                // Only the first read waits, the next ones take what is already received
+                Result result = serial->readSome(region, regionSize, first ? deadline : 0, &totalRead);
 
-            return write("Sending `Enter data mode (device calibration)`", buffer, sizeof(buffer));
+                if (totalRead > 0) {
+                    LOGGER(LiteVNA, "Received{}", formatBytes(region, totalRead));
+                    fifoBuffer.commitWrite(totalRead);
+                }
+                if (result) {
+                    if (result.code != "serial_port_timeout") {
+                        return result;
+                    }
+                    return first ? Result("lite_vna_timeout", "Timeout reading LiteVNA Fifo data") : Result::ok();
+                }
+                if (totalRead < regionSize) {
+                    break;
+                }
+                first = false;
+            }
+            return Result::ok();
         }
 
-        Result leaveDataMode() {
-            uint8_t buffer[] = { LITEVNA_CMD_WRITE1, LITEVNA_REG_SAMPLES_MODE, LITEVNA_SAMPLES_MODE_LEAVE };
+        // Verifies and converts `frameCount` contiguous frames, then accumulates the running mean and
+        // the sum of squared differences (Welford) of the values received for each point
+        Result decodeFifoData(const uint8_t* frames, size_t frameCount, const ScanSegment& segment, uint16_t average, ScanValues& values, vector<uint16_t>& decoded) {
+            size_t invalid = FifoDecoder::verify(frames, frameCount);
 
-            return write("Sending `Leave data mode`", buffer, sizeof(buffer));
+            if (invalid < frameCount) {
+                return Result("lite_vna_error", "Invalid Checksum `{}`", FifoDecoder::checksum(frames + invalid * sizeof(LiteVNAFifoData)));
+            }
+            FifoDecoder::convert(frames, frameCount, fifoFrames);
+
+            for (size_t k = 0; k < frameCount; k++) {
+                uint16_t freqIndex = fifoFrames.freqIndex[k];
+
+                if (freqIndex >= segment.points) {
+                    return Result("lite_vna_error", "Invalid Frequency Index `{}`", freqIndex);
+                }
+                size_t index = segment.offset + freqIndex;
+                uint16_t n = ++decoded[index];
+
+                if (n > average) {
+                    return Result("lite_vna_error", "Unexpected value for Frequency Index `{}`", index);
+                }
+                complex<float> out0(fifoFrames.channel0OutRe[k], fifoFrames.channel0OutIm[k]);
+                complex<float> in0(fifoFrames.channel0InRe[k], fifoFrames.channel0InIm[k]);
+                complex<float> in1(fifoFrames.channel1InRe[k], fifoFrames.channel1InIm[k]);
+
+                if (n == 1) {
+                    values.channel0Out[index] = out0;
+                    values.channel0In[index] = in0;
+                    values.channel1In[index] = in1;
+                    continue;
+                }
+                complex<float> delta0 = in0 - values.channel0In[index];
+                complex<float> delta1 = in1 - values.channel1In[index];
+
+                values.channel0Out[index] += (out0 - values.channel0Out[index]) / (float)n;
+                values.channel0In[index] += delta0 / (float)n;
+                values.channel1In[index] += delta1 / (float)n;
+                values.channel0InDeviation[index] += (conj(delta0) * (in0 - values.channel0In[index])).real();
+                values.channel1InDeviation[index] += (conj(delta1) * (in1 - values.channel1In[index])).real();
+
+                // Deviation holds the sum of squared differences until the last value of the point
+                if (n == average) {
+                    values.channel0InDeviation[index] = sqrtf(values.channel0InDeviation[index] / (average - 1));
+                    values.channel1InDeviation[index] = sqrtf(values.channel1InDeviation[index] / (average - 1));
+                }
+            }
+            return Result::ok();
         }
 
-        Result readFifo() {
-            uint8_t buffer[] = { LITEVNA_CMD_READ_FIFO, LITEVNA_REG_READ_FIFO, LITEVNA_SEND_ALL_POINTS };
+        // Writes the pending `commands` at once, if any
+        Result sendCommands(const string& text) {
+            if (commands.empty()) {
+                return Result::ok();
+            }
+            LOGGER(LiteVNA, text + formatBytes(commands.data(), commands.size()));
+
+            Result result = serial->write(commands.data(), commands.size(), DateTime::monotonicMilliseconds() + LITEVNA_RESPONSE_TIMEOUT_MS);
+            commands.clear();
 
-            return write("Sending `Read Fifo`", buffer, sizeof(buffer));
+            return result;
+        }
+
+        // Keeps up to LITEVNA_FIFO_CHUNKS_IN_FLIGHT chunk requests ahead of the decoded points, so the
+        // device transfers what it has already measured while the sweep is still running.
+        // A chunk size of 0 requests all points at once. Requests are appended to `commands`.
+        void requestFifo(size_t points, size_t received, size_t& requested) {
+            size_t chunk = config->fifoChunk;
+
+            if (chunk == 0) {
+                if (requested == 0) {
+                    commands.readFifo(LITEVNA_SEND_ALL_POINTS);
+                    requested = points;
+                }
+                return;
+            }
+            while (requested < points && (requested - received) < chunk * LITEVNA_FIFO_CHUNKS_IN_FLIGHT) {
+                size_t total = min(chunk, points - requested);
+
+                commands.readFifo((uint8_t)total);
+                requested += total;
+            }
         }
 
         Result checkIndicate() {
@@ -277,18 +446,16 @@ namespace litevnaserver {
             if (result) {
                 return result;
             }
-            this_thread::sleep_for(chrono::milliseconds(50));
-
             uint8_t bufferResp[1];
 
-            result = serial->read(bufferResp, sizeof(bufferResp), nullptr);
+            result = readResponse(bufferResp, sizeof(bufferResp));
 
             if (result) {
                 return result;
             }
             LOGGER(LiteVNA, "Received{}", formatBytes(bufferResp, sizeof(bufferResp)));
 
-            if (bufferResp[0] != 0x32) {
+            if (bufferResp[0] != LITEVNA_INDICATE_RESPONSE) {
                 return Result("lite_vna_error", "Invalid device indicate, expected 0x32 but found 0x{}. Is LiteVNA connected to the correct com port?", su::toHex((int)bufferResp[0]));
             }
             return Result::ok();
@@ -299,23 +466,21 @@ namespace litevnaserver {
 
             LOGGER(LiteVNA, "Sending `Device Variant`{}", formatBytes(bufferReq, sizeof(bufferReq)));
 
-            Result result = serial->write(bufferReq, sizeof(bufferReq));
+            Result result = serial->write(bufferReq, sizeof(bufferReq), DateTime::monotonicMilliseconds() + LITEVNA_RESPONSE_TIMEOUT_MS);
 
             if (result) {
                 return result;
             }
-            this_thread::sleep_for(chrono::milliseconds(50));
-
             uint8_t bufferResp[1];
 
-            result = serial->read(bufferResp, sizeof(bufferResp), nullptr);
+            result = readResponse(bufferResp, sizeof(bufferResp));
 
             if (result) {
                 return result;
             }
             LOGGER(LiteVNA, "Received{}", formatBytes(bufferResp, sizeof(bufferResp)));
 
-            if (bufferResp[0] != 0x02) {
+            if (bufferResp[0] != LITEVNA_DEVICE_VARIANT) {
                 return Result("lite_vna_error", "Invalid device variant, expected 0x02 but found 0x{}. Is LiteVNA connected to the correct com port?", su::toHex((int)bufferResp[0]));
             }
             return Result::ok();
@@ -326,55 +491,39 @@ namespace litevnaserver {
 
             LOGGER(LiteVNA, "Sending `Protocol Version`{}", formatBytes(bufferReq, sizeof(bufferReq)));
 
-            Result result = serial->write(bufferReq, sizeof(bufferReq));
+            Result result = serial->write(bufferReq, sizeof(bufferReq), DateTime::monotonicMilliseconds() + LITEVNA_RESPONSE_TIMEOUT_MS);
 
             if (result) {
                 return result;
             }
-            this_thread::sleep_for(chrono::milliseconds(50));
-
             uint8_t bufferResp[1];
 
-            result = serial->read(bufferResp, sizeof(bufferResp), nullptr);
+            result = readResponse(bufferResp, sizeof(bufferResp));
 
             if (result) {
                 return result;
             }
             LOGGER(LiteVNA, "Received{}", formatBytes(bufferResp, sizeof(bufferResp)));
 
-            if (bufferResp[0] != 0x01) {
+            if (bufferResp[0] != LITEVNA_PROTOCOL_VERSION) {
                 return Result("lite_vna_error", "Invalidprotocol version, expected 0x01 but found 0x{}.", su::toHex((int)bufferResp[0]));
             }
             return Result::ok();
         }
 
-        Result sendCmdWrite2(const string& text, uint8_t cmd, uint16_t value) {
-            uint8_t buffer[2 + sizeof(value)];
-
-            *buffer = LITEVNA_CMD_WRITE2;
-            *(buffer + 1) = cmd;
-            *((uint16_t*)(buffer + 2)) = value;
-
-            return write(text, buffer, sizeof(buffer));
-        }
-
-        Result sendCmdWrite8(const string& text, uint8_t cmd, uint64_t value) {
-            uint8_t buffer[2 + sizeof(value)];
-
-            *buffer = LITEVNA_CMD_WRITE8;
-            *(buffer + 1) = cmd;
-            *((uint64_t*)(buffer + 2)) = value;
+        Result readResponse(uint8_t* buffer, size_t size) {
+            size_t totalRead = 0;
 
-            return write(text, buffer, sizeof(buffer));
+            return serial->read(buffer, size, DateTime::monotonicMilliseconds() + LITEVNA_RESPONSE_TIMEOUT_MS, &totalRead);
         }
 
         Result write(const string& text, uint8_t* buffer, size_t size) {
             LOGGER(LiteVNA, text + formatBytes(buffer, size));
 
-            return serial->write(buffer, size);
+            return serial->write(buffer, size, DateTime::monotonicMilliseconds() + LITEVNA_RESPONSE_TIMEOUT_MS);
         }
 
-        string formatBytes(uint8_t* buffer, size_t size) {
+        string formatBytes(const uint8_t* buffer, size_t size) {
             string hex;
 
             for (size_t n = 0; n < size; n++) {
@@ -0,0 +1,38 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+// LiteVNA 64 serial protocol, shared by LiteVNA and the emulator
+
+#define LITEVNA_CLEAR_FIFO 0,0,0,0,0,0,0,0
+
+#define LITEVNA_CMD_INDICATE  0x0D
+#define LITEVNA_CMD_READ1     0x10
+#define LITEVNA_CMD_READ2     0x11
+#define LITEVNA_CMD_READ4     0x12
+#define LITEVNA_CMD_READ_FIFO 0x18
+#define LITEVNA_CMD_WRITE1    0x20
+#define LITEVNA_CMD_WRITE2    0x21
+#define LITEVNA_CMD_WRITE4    0x22
+#define LITEVNA_CMD_WRITE8    0x23
+
+#define LITEVNA_REG_SWEEP_START           0x00
+#define LITEVNA_REG_SWEEP_STEP            0x10
+#define LITEVNA_REG_SWEEP_POINTS          0x20
+#define LITEVNA_REG_VALUES_PER_FREQUENCY  0x22
+#define LITEVNA_REG_SAMPLES_MODE          0x26
+#define LITEVNA_REG_READ_FIFO             0x30
+#define LITEVNA_REG_DEVICE_VARIANT        0xF0
+#define LITEVNA_REG_PROTOCOL_VERSION      0xF1
+
+#define LITEVNA_SEND_ALL_POINTS           0x00
+
+#define LITEVNA_SAMPLES_MODE_APP_CALIBRATION 0x01
+#define LITEVNA_SAMPLES_MODE_LEAVE 0x02
+#define LITEVNA_SAMPLES_MODE_DEVICE_CALIBRATION 0x03
+
+// Responses identifying a LiteVNA 64
+#define LITEVNA_INDICATE_RESPONSE         0x32
+#define LITEVNA_DEVICE_VARIANT            0x02
+#define LITEVNA_PROTOCOL_VERSION          0x01
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include "lib/FastMath.h"
+
+namespace litevnaserver {
+    enum class Precision {
+        // libm results, same as LiteVNA::logMag, phase and swr
+        Exact,
+        // Polynomial approximations (FastMath), vectorized with SSE2. Errors are below 5e-5 dB for
+        // log_mag and 2e-4 degrees for phase, swr is the same as in Exact.
+        Fast
+    };
+
+    // log_mag, phase and swr of a range of sweep points, computed channel by channel. The buffers are
+    // reused between calls.
+    class ScanMetrics {
+    public:
+        vector<float> s11LogMag;
+        vector<float> s11Phase;
+        vector<float> s11Swr;
+        vector<float> s21LogMag;
+        vector<float> s21Phase;
+
+        void compute(const ScanValues& values, size_t begin, size_t end, Precision precision) {
+            size_t count = end - begin;
+
+            s11LogMag.resize(count);
+            s11Phase.resize(count);
+            s11Swr.resize(count);
+            s21LogMag.resize(count);
+            s21Phase.resize(count);
+
+            const complex<float>* s11 = values.channel0In.data() + begin;
+            const complex<float>* s21 = values.channel1In.data() + begin;
+
+            if (precision == Precision::Exact) {
+                for (size_t n = 0; n < count; n++) {
+                    s11LogMag[n] = LiteVNA::logMag(s11[n]);
+                    s11Phase[n] = LiteVNA::phase(s11[n]);
+                    s11Swr[n] = LiteVNA::swr(s11[n]);
+                    s21LogMag[n] = LiteVNA::logMag(s21[n]);
+                    s21Phase[n] = LiteVNA::phase(s21[n]);
+                }
+                return;
+            }
+            logMag(s11, count, s11LogMag.data());
+            phase(s11, count, s11Phase.data());
+            swr(s11, count, s11Swr.data());
+            logMag(s21, count, s21LogMag.data());
+            phase(s21, count, s21Phase.data());
+        }
+
+        // 10 * log10(|v|^2), 0 for v = 0
+        static void logMag(const complex<float>* values, size_t count, float* out) {
+            const float scale = 10.0f / logf(10.0f);
+            size_t n = 0;
+
+#ifdef FAST_MATH_SSE2
+            for (; n + 4 <= count; n += 4) {
+                __m128 re;
+                __m128 im;
+                load4(values + n, re, im);
+
+                __m128 l = _mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im));
+                __m128 r = _mm_mul_ps(FastMath::log(l), _mm_set1_ps(scale));
+
+                _mm_storeu_ps(out + n, _mm_andnot_ps(_mm_cmpeq_ps(l, _mm_setzero_ps()), r));
+            }
+#endif
+            for (; n < count; n++) {
+                float l = values[n].real() * values[n].real() + values[n].imag() * values[n].imag();
+
+                out[n] = l == 0 ? 0.0f : FastMath::log(l) * scale;
+            }
+        }
+
+        // Degrees
+        static void phase(const complex<float>* values, size_t count, float* out) {
+            const float scale = 180.0f / FAST_MATH_PI;
+            size_t n = 0;
+
+#ifdef FAST_MATH_SSE2
+            for (; n + 4 <= count; n += 4) {
+                __m128 re;
+                __m128 im;
+                load4(values + n, re, im);
+
+                _mm_storeu_ps(out + n, _mm_mul_ps(FastMath::atan2(im, re), _mm_set1_ps(scale)));
+            }
+#endif
+            for (; n < count; n++) {
+                out[n] = FastMath::atan2(values[n].imag(), values[n].real()) * scale;
+            }
+        }
+
+        static void swr(const complex<float>* values, size_t count, float* out) {
+            const float limit = (LITEVNA_VSWR_MAX - 1.0f) / (LITEVNA_VSWR_MAX + 1.0f);
+            size_t n = 0;
+
+#ifdef FAST_MATH_SSE2
+            for (; n + 4 <= count; n += 4) {
+                __m128 re;
+                __m128 im;
+                load4(values + n, re, im);
+
+                __m128 x = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(re, re), _mm_mul_ps(im, im)));
+                __m128 one = _mm_set1_ps(1.0f);
+                __m128 r = _mm_div_ps(_mm_add_ps(one, x), _mm_sub_ps(one, x));
+
+                _mm_storeu_ps(out + n, FastMath::select(_mm_cmpgt_ps(x, _mm_set1_ps(limit)), _mm_set1_ps(LITEVNA_VSWR_MAX), r));
+            }
+#endif
+            for (; n < count; n++) {
+                out[n] = LiteVNA::swr(values[n]);
+            }
+        }
+
+    private:
+#ifdef FAST_MATH_SSE2
+        // Splits 4 complex values into real and imaginary lanes
+        static void load4(const complex<float>* values, __m128& re, __m128& im) {
+            __m128 a = _mm_loadu_ps((const float*)values);
+            __m128 b = _mm_loadu_ps((const float*)(values + 2));
+
+            re = _mm_shuffle_ps(a, b, _MM_SHUFFLE(2, 0, 2, 0));
+            im = _mm_shuffle_ps(a, b, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+#endif
+    };
+}
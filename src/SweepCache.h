@@ -0,0 +1,128 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <list>
+
+#define SWEEP_CACHE_MAX_ENTRIES 32
+
+namespace litevnaserver {
+    // Recently completed sweeps, kept for `Config::cacheTtl` milliseconds. A request is served from
+    // the cache if it matches a sweep exactly or if its frequency grid is a subset of a cached one.
+    // Used only from the event loop thread.
+    class SweepCache {
+    public:
+        // 1. Lifecycle
+        SweepCache() = default;
+        SweepCache(const SweepCache&) = delete;
+        SweepCache& operator=(const SweepCache&) = delete;
+        SweepCache(const SweepCache&&) = delete;
+        SweepCache& operator=(const SweepCache&&) = delete;
+        ~SweepCache() = default;
+
+        // 2. Dependency injection
+        void setConfig(Config* _config) {
+            config = _config;
+        }
+
+        // 3. Functionalities
+        bool isEnabled() const {
+            return config->cacheTtl > 0;
+        }
+
+        void insert(shared_ptr<SweepJob> job) {
+            if (!isEnabled() || job->result) {
+                return;
+            }
+            uint64_t now = DateTime::monotonicMilliseconds();
+
+            removeExpired(now);
+
+            if (entries.size() >= SWEEP_CACHE_MAX_ENTRIES) {
+                entries.pop_back();
+            }
+            entries.push_front(Entry{ job, now });
+        }
+
+        // Returns the cached sweep, a slice of a cached sweep, or nullptr
+        shared_ptr<SweepJob> find(const SweepSpec& spec) {
+            if (!isEnabled()) {
+                return nullptr;
+            }
+            removeExpired(DateTime::monotonicMilliseconds());
+
+            // Newest entries first
+            for (const Entry& entry : entries) {
+                const SweepSpec& cached = entry.job->spec;
+
+                if (cached == spec) {
+                    return entry.job;
+                }
+                size_t offset;
+                size_t stride;
+
+                if (contains(cached, spec, &offset, &stride)) {
+                    shared_ptr<SweepJob> job = make_shared<SweepJob>();
+                    job->id = entry.job->id;
+                    job->spec = spec;
+                    slice(entry.job->values, offset, stride, spec.points, job->values);
+
+                    return job;
+                }
+            }
+            return nullptr;
+        }
+
+    private:
+        struct Entry {
+            shared_ptr<SweepJob> job;
+            // Monotonic, so clock changes neither keep entries alive nor expire them
+            uint64_t timestamp;
+        };
+
+        Config* config = nullptr;
+        list<Entry> entries;
+
+        void removeExpired(uint64_t now) {
+            while (entries.size() > 0 && entries.back().timestamp + config->cacheTtl <= now) {
+                entries.pop_back();
+            }
+        }
+
+        // Every requested frequency must be a point of the cached grid
+        static bool contains(const SweepSpec& cached, const SweepSpec& spec, size_t* offset, size_t* stride) {
+            if (spec.average != cached.average || spec.device != cached.device || spec.calibration != cached.calibration || spec.calibrationVersion != cached.calibrationVersion ||
+                spec.start < cached.start || (spec.start - cached.start) % cached.step != 0 || spec.step % cached.step != 0) {
+                return false;
+            }
+            *offset = (size_t)((spec.start - cached.start) / cached.step);
+            *stride = (size_t)(spec.step / cached.step);
+
+            return *offset + (size_t)(spec.points - 1) * *stride < cached.points;
+        }
+
+        static void slice(const ScanValues& from, size_t offset, size_t stride, size_t points, ScanValues& to) {
+            to.channel0Out.resize(points);
+            to.channel0In.resize(points);
+            to.channel1In.resize(points);
+
+            for (size_t n = 0; n < points; n++) {
+                size_t index = offset + n * stride;
+
+                to.channel0Out[n] = from.channel0Out[index];
+                to.channel0In[n] = from.channel0In[index];
+                to.channel1In[n] = from.channel1In[index];
+            }
+            if (from.channel0InDeviation.size() > 0) {
+                to.channel0InDeviation.resize(points);
+                to.channel1InDeviation.resize(points);
+
+                for (size_t n = 0; n < points; n++) {
+                    to.channel0InDeviation[n] = from.channel0InDeviation[offset + n * stride];
+                    to.channel1InDeviation[n] = from.channel1InDeviation[offset + n * stride];
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,475 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <array>
+
+#include "lib/CBOR.h"
+#include "lib/Float16.h"
+#include "lib/JSONWriter.h"
+
+#define SWEEP_ENCODER_BINARY_HEADER_SIZE 36
+#define SWEEP_ENCODER_TOUCHSTONE_MIN_DB -200.0f
+
+namespace litevnaserver {
+    // Samples of binary sweeps
+    enum class SampleFormat : uint8_t {
+        Float32 = 0,
+        Float16 = 1,
+        // Scaled by a float32 factor sent before them
+        Int16 = 2
+    };
+
+    // Output format of a sweep. A document is built by `begin`, `points` for consecutive ranges and
+    // `end`, or `fail` if the sweep failed after it began. Streamable encoders receive the ranges
+    // while the sweep runs, the others the whole sweep in one range. Everything is appended to the
+    // buffer that is handed to the socket.
+    class SweepEncoder {
+    public:
+        virtual ~SweepEncoder() = default;
+
+        virtual const char* contentType() const = 0;
+
+        // Encoder and options, encoders of the same variant produce the same document
+        virtual string variant() const = 0;
+
+        virtual bool isStreamable() const {
+            return true;
+        }
+
+        virtual void begin(string& /*out*/, const SweepJob& /*job*/) {
+        }
+
+        virtual void points(string& out, const SweepJob& job, size_t begin, size_t end) = 0;
+
+        virtual void end(string& /*out*/, const SweepJob& /*job*/, bool /*cached*/) {
+        }
+
+        virtual void fail(string& /*out*/, const string& /*description*/) {
+        }
+
+        void encode(string& out, const SweepJob& job, bool cached) {
+            begin(out, job);
+            points(out, job, 0, job.spec.points);
+            end(out, job, cached);
+        }
+
+    protected:
+        static void appendNumber(string& out, double value) {
+            char buffer[32];
+            int size = snprintf(buffer, sizeof(buffer), "%.7g", value);
+
+            out.append(buffer, (size_t)size);
+        }
+
+        static void appendFrequency(string& out, uint64_t frequency) {
+            char buffer[24];
+            int size = snprintf(buffer, sizeof(buffer), "%llu", (unsigned long long)frequency);
+
+            out.append(buffer, (size_t)size);
+        }
+    };
+
+    // {"result":[{"freq": .., "s11": {"log_mag": .., "phase": .., "swr": ..},"s21": {..}}, ..],"cached": ..}
+    // `deviation` adds the standard deviation of the averaged linear values, when the sweep was averaged.
+    // Numbers have `digits` significant digits, or as many as needed to read back the float if 0.
+    class JSONEncoder : public SweepEncoder {
+    public:
+        JSONEncoder(ScanMetrics& _metrics, bool _deviation, Precision _precision, int _digits) : metrics(_metrics), deviation(_deviation), precision(_precision), digits(_digits) {
+        }
+
+        const char* contentType() const override {
+            return "application/json";
+        }
+
+        string variant() const override {
+            return su::format("json,{},{},{}", deviation ? 1 : 0, precision == Precision::Fast ? "fast" : "exact", digits);
+        }
+
+        void begin(string& out, const SweepJob& /*job*/) override {
+            JSONWriter::appendLiteral(out, R"({"result":[)");
+        }
+
+        // The metrics of the whole range are computed first, and the buffer grown once for the range
+        void points(string& out, const SweepJob& job, size_t begin, size_t end) override {
+            metrics.compute(job.values, begin, end, precision);
+            bool withDeviation = deviation && job.values.channel0InDeviation.size() > 0;
+            // Keys and frequency, then the numbers with sign, point and exponent
+            size_t pointSize = 128 + (withDeviation ? 7 : 5) * ((digits > 0 ? (size_t)digits : JSON_WRITER_MAX_DIGITS) + 7);
+
+            out.reserve(out.size() + (end - begin) * pointSize);
+
+            for (size_t n = begin; n < end; n++) {
+                size_t k = n - begin;
+
+                if (n > 0) {
+                    out += ',';
+                }
+                JSONWriter::appendLiteral(out, R"({"freq": )");
+                JSONWriter::appendUnsigned(out, job.spec.start + n * job.spec.step);
+                JSONWriter::appendLiteral(out, R"(, "s11": {"log_mag": )");
+                JSONWriter::appendFloat(out, metrics.s11LogMag[k], digits);
+                JSONWriter::appendLiteral(out, R"(, "phase": )");
+                JSONWriter::appendFloat(out, metrics.s11Phase[k], digits);
+                JSONWriter::appendLiteral(out, R"(, "swr": )");
+                JSONWriter::appendFloat(out, metrics.s11Swr[k], digits);
+
+                if (withDeviation) {
+                    JSONWriter::appendLiteral(out, R"(, "std": )");
+                    JSONWriter::appendFloat(out, job.values.channel0InDeviation[n], digits);
+                }
+                JSONWriter::appendLiteral(out, R"(},"s21": {"log_mag": )");
+                JSONWriter::appendFloat(out, metrics.s21LogMag[k], digits);
+                JSONWriter::appendLiteral(out, R"(, "phase": )");
+                JSONWriter::appendFloat(out, metrics.s21Phase[k], digits);
+
+                if (withDeviation) {
+                    JSONWriter::appendLiteral(out, R"(, "std": )");
+                    JSONWriter::appendFloat(out, job.values.channel1InDeviation[n], digits);
+                }
+                JSONWriter::appendLiteral(out, "}}");
+            }
+        }
+
+        void end(string& out, const SweepJob& /*job*/, bool cached) override {
+            out += ']';
+            appendCached(out, cached);
+        }
+
+        // Last member of the responses, shared with /litevna/tdr so both end the same way
+        static void appendCached(string& out, bool cached) {
+            JSONWriter::appendLiteral(out, R"(,"cached":)");
+            JSONWriter::appendBool(out, cached);
+            out += '}';
+        }
+
+        void fail(string& out, const string& description) override {
+            JSONWriter::appendLiteral(out, R"(],"error": )");
+            JSONWriter::appendString(out, description);
+            out += '}';
+        }
+
+    private:
+        ScanMetrics& metrics;
+        bool deviation;
+        Precision precision;
+        int digits;
+    };
+
+    // Binary sweep, little-endian:
+    //   char[4] "LVNA", uint8 version (1), uint8 sample format (SampleFormat), uint16 channel mask
+    //   (bit 0 = s11, bit 1 = s21), uint32 points, uint64 start, uint64 step, uint64 sweep id,
+    //   followed by `points` complex values (real, imaginary) of each channel in the mask.
+    //   Int16 samples are preceded by a float32 scale, value = sample * scale.
+    // Channels are sent one after the other, so it is not streamable.
+    class BinaryEncoder : public SweepEncoder {
+    public:
+        explicit BinaryEncoder(SampleFormat _sample) : sample(_sample) {
+        }
+
+        const char* contentType() const override {
+            return "application/octet-stream";
+        }
+
+        string variant() const override {
+            return su::format("bin,{}", (int)sample);
+        }
+
+        bool isStreamable() const override {
+            return false;
+        }
+
+        void begin(string& out, const SweepJob& job) override {
+            char header[SWEEP_ENCODER_BINARY_HEADER_SIZE];
+            uint16_t channelMask = 0x03;
+            uint32_t totalPoints = job.spec.points;
+
+            memcpy(header, "LVNA", 4);
+            header[4] = 1;
+            header[5] = (char)sample;
+            memcpy(header + 6, &channelMask, sizeof(channelMask));
+            memcpy(header + 8, &totalPoints, sizeof(totalPoints));
+            memcpy(header + 12, &job.spec.start, sizeof(uint64_t));
+            memcpy(header + 20, &job.spec.step, sizeof(uint64_t));
+            memcpy(header + 28, &job.id, sizeof(uint64_t));
+
+            size_t sampleSize = sample == SampleFormat::Float32 ? sizeof(float) : sizeof(uint16_t);
+            out.reserve(out.size() + sizeof(header) + sizeof(float) + (size_t)totalPoints * 4 * sampleSize);
+            out.append(header, sizeof(header));
+
+            if (sample == SampleFormat::Int16) {
+                // One scale for both channels, so their values compare directly. Non-finite values (a zero
+                // reference gives an infinite ratio) are clamped by `points`, they must not set the scale.
+                float maximum = 0.0f;
+
+                for (const float* channel : channels(job)) {
+                    for (size_t n = 0; n < (size_t)totalPoints * 2; n++) {
+                        if (isfinite(channel[n])) {
+                            maximum = max(maximum, fabsf(channel[n]));
+                        }
+                    }
+                }
+                scale = maximum > 0.0f ? maximum / 32767.0f : 1.0f;
+                out.append((const char*)&scale, sizeof(scale));
+            }
+        }
+
+        // complex<float> is laid out as two floats, the host is expected to be little-endian
+        void points(string& out, const SweepJob& job, size_t begin, size_t end) override {
+            for (const float* channel : channels(job)) {
+                if (sample == SampleFormat::Float32) {
+                    out.append((const char*)(channel + begin * 2), (end - begin) * sizeof(complex<float>));
+                    continue;
+                }
+                for (size_t n = begin * 2; n < end * 2; n++) {
+                    uint16_t value;
+
+                    if (sample == SampleFormat::Float16) {
+                        value = Float16::fromFloat(channel[n]);
+                    }
+                    else {
+                        float scaled = channel[n] / scale;
+                        value = (uint16_t)(scaled >= -32767.0f && scaled <= 32767.0f ? (int16_t)lrintf(scaled) : (scaled > 0 ? 32767 : (scaled < 0 ? -32767 : 0)));
+                    }
+                    out.append((const char*)&value, sizeof(value));
+                }
+            }
+        }
+
+    private:
+        SampleFormat sample;
+        float scale = 1.0f;
+
+        static array<const float*, 2> channels(const SweepJob& job) {
+            return { (const float*)job.values.channel0In.data(), (const float*)job.values.channel1In.data() };
+        }
+    };
+
+    // CBOR (RFC 8949) with the fields of the JSON response, each one a typed array (RFC 8746) of all
+    // the points instead of an array of objects:
+    //   {"result": {"freq": uint64[], "s11": {"log_mag": float32[], "phase": .., "swr": .., "std": ..},
+    //   "s21": {"log_mag": .., "phase": .., "std": ..}}, "cached": bool}
+    // "std" only with `deviation` when the sweep was averaged. Arrays are whole, so it is not streamable.
+    class CBOREncoder : public SweepEncoder {
+    public:
+        CBOREncoder(ScanMetrics& _metrics, bool _deviation, Precision _precision) : metrics(_metrics), deviation(_deviation), precision(_precision) {
+        }
+
+        const char* contentType() const override {
+            return "application/cbor";
+        }
+
+        string variant() const override {
+            return su::format("cbor,{},{}", deviation ? 1 : 0, precision == Precision::Fast ? "fast" : "exact");
+        }
+
+        bool isStreamable() const override {
+            return false;
+        }
+
+        void begin(string& out, const SweepJob& job) override {
+            size_t points = job.spec.points;
+            // Typed arrays of 4 byte values and their heads, the frequencies take 8 bytes each
+            out.reserve(out.size() + 128 + points * (sizeof(uint64_t) + 7 * sizeof(float)));
+
+            CBOR::appendMap(out, 2);
+            CBOR::appendText(out, "result");
+            CBOR::appendMap(out, 3);
+        }
+
+        void points(string& out, const SweepJob& job, size_t begin, size_t end) override {
+            metrics.compute(job.values, begin, end, precision);
+            bool withDeviation = deviation && job.values.channel0InDeviation.size() > 0;
+            size_t count = end - begin;
+
+            CBOR::appendText(out, "freq");
+            CBOR::appendTag(out, CBOR_TAG_UINT64_LE);
+            CBOR::appendBytesHead(out, count * sizeof(uint64_t));
+
+            for (size_t n = begin; n < end; n++) {
+                uint64_t freq = job.spec.start + n * job.spec.step;
+                out.append((const char*)&freq, sizeof(freq));
+            }
+            CBOR::appendText(out, "s11");
+            CBOR::appendMap(out, withDeviation ? 4 : 3);
+            appendArray(out, "log_mag", metrics.s11LogMag.data(), count);
+            appendArray(out, "phase", metrics.s11Phase.data(), count);
+            appendArray(out, "swr", metrics.s11Swr.data(), count);
+
+            if (withDeviation) {
+                appendArray(out, "std", job.values.channel0InDeviation.data() + begin, count);
+            }
+            CBOR::appendText(out, "s21");
+            CBOR::appendMap(out, withDeviation ? 3 : 2);
+            appendArray(out, "log_mag", metrics.s21LogMag.data(), count);
+            appendArray(out, "phase", metrics.s21Phase.data(), count);
+
+            if (withDeviation) {
+                appendArray(out, "std", job.values.channel1InDeviation.data() + begin, count);
+            }
+        }
+
+        void end(string& out, const SweepJob& /*job*/, bool cached) override {
+            CBOR::appendText(out, "cached");
+            CBOR::appendBool(out, cached);
+        }
+
+    private:
+        ScanMetrics& metrics;
+        bool deviation;
+        Precision precision;
+
+        static void appendArray(string& out, const char* name, const float* values, size_t count) {
+            CBOR::appendText(out, name);
+            CBOR::appendFloat32Array(out, values, count);
+        }
+    };
+
+    // RFC 4180 CSV, one line per point: freq,s11_re,s11_im,s21_re,s21_im, plus s11_std,s21_std with
+    // `deviation` when the sweep was averaged. A failure while streaming ends with an "error" line.
+    class CSVEncoder : public SweepEncoder {
+    public:
+        explicit CSVEncoder(bool _deviation) : deviation(_deviation) {
+        }
+
+        const char* contentType() const override {
+            return "text/csv";
+        }
+
+        string variant() const override {
+            return su::format("csv,{}", deviation ? 1 : 0);
+        }
+
+        void begin(string& out, const SweepJob& job) override {
+            out += hasDeviation(job) ? "freq,s11_re,s11_im,s21_re,s21_im,s11_std,s21_std\r\n" : "freq,s11_re,s11_im,s21_re,s21_im\r\n";
+        }
+
+        void points(string& out, const SweepJob& job, size_t begin, size_t end) override {
+            bool withDeviation = hasDeviation(job);
+
+            for (size_t n = begin; n < end; n++) {
+                appendFrequency(out, job.spec.start + n * job.spec.step);
+                out += ',';
+                appendNumber(out, job.values.channel0In[n].real());
+                out += ',';
+                appendNumber(out, job.values.channel0In[n].imag());
+                out += ',';
+                appendNumber(out, job.values.channel1In[n].real());
+                out += ',';
+                appendNumber(out, job.values.channel1In[n].imag());
+
+                if (withDeviation) {
+                    out += ',';
+                    appendNumber(out, job.values.channel0InDeviation[n]);
+                    out += ',';
+                    appendNumber(out, job.values.channel1InDeviation[n]);
+                }
+                out += "\r\n";
+            }
+        }
+
+        void fail(string& out, const string& description) override {
+            // Quotes inside a quoted field are doubled (RFC 4180)
+            out += "error,\"";
+
+            for (char c : description) {
+                out += c;
+
+                if (c == '"') {
+                    out += '"';
+                }
+            }
+            out += "\"\r\n";
+        }
+
+    private:
+        bool deviation;
+
+        // Known before the first point: averaged sweeps always carry deviations
+        bool hasDeviation(const SweepJob& job) const {
+            return deviation && job.spec.average > 1;
+        }
+    };
+
+    enum class TouchstoneFormat {
+        // Real and imaginary
+        RI,
+        // Linear magnitude and angle in degrees
+        MA,
+        // Magnitude in dB and angle in degrees
+        DB
+    };
+
+    // Touchstone 1.1 two port file (.s2p), 50 ohm, frequencies in Hz. LiteVNA only measures S11 and
+    // S21, S12 and S22 are written as zero (SWEEP_ENCODER_TOUCHSTONE_MIN_DB in DB format).
+    class TouchstoneEncoder : public SweepEncoder {
+    public:
+        explicit TouchstoneEncoder(TouchstoneFormat _format) : format(_format) {
+        }
+
+        const char* contentType() const override {
+            return "application/x-touchstone";
+        }
+
+        string variant() const override {
+            return su::format("s2p,{}", formatName());
+        }
+
+        void begin(string& out, const SweepJob& job) override {
+            out += su::format("! LiteVNAServer sweep {}, S12 and S22 are not measured\n# HZ S {} R 50\n", job.id, formatName());
+        }
+
+        void points(string& out, const SweepJob& job, size_t begin, size_t end) override {
+            for (size_t n = begin; n < end; n++) {
+                appendFrequency(out, job.spec.start + n * job.spec.step);
+                appendParameter(out, job.values.channel0In[n]);
+                appendParameter(out, job.values.channel1In[n]);
+                appendParameter(out, complex<float>(0.0f, 0.0f));
+                appendParameter(out, complex<float>(0.0f, 0.0f));
+                out += '\n';
+            }
+        }
+
+        void fail(string& out, const string& description) override {
+            // A comment ends at the end of the line
+            out += "! error: ";
+
+            for (char c : description) {
+                out += c == '\r' || c == '\n' ? ' ' : c;
+            }
+            out += '\n';
+        }
+
+    private:
+        TouchstoneFormat format;
+
+        const char* formatName() const {
+            return format == TouchstoneFormat::RI ? "RI" : (format == TouchstoneFormat::MA ? "MA" : "DB");
+        }
+
+        void appendParameter(string& out, complex<float> value) const {
+            out += ' ';
+
+            switch (format) {
+                case TouchstoneFormat::RI:
+                    appendNumber(out, value.real());
+                    out += ' ';
+                    appendNumber(out, value.imag());
+                    return;
+
+                case TouchstoneFormat::MA:
+                    appendNumber(out, abs(value));
+                    break;
+
+                case TouchstoneFormat::DB: {
+                    float squared = value.real() * value.real() + value.imag() * value.imag();
+                    appendNumber(out, squared > 0.0f ? max(SWEEP_ENCODER_TOUCHSTONE_MIN_DB, 10.0f * log10f(squared)) : SWEEP_ENCODER_TOUCHSTONE_MIN_DB);
+                    break;
+                }
+            }
+            out += ' ';
+            appendNumber(out, LiteVNA::phase(value));
+        }
+    };
+}
@@ -0,0 +1,293 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "lib/SPSCQueue.h"
+
+#define SWEEP_SERVICE_QUEUE_SIZE 256
+#define SWEEP_SERVICE_MONITOR_RETRY_MS 1000
+
+namespace litevnaserver {
+    struct SweepSpec {
+        uint64_t start = 0;
+        uint64_t step = 0;
+        uint32_t points = 0;
+        uint16_t average = 1;
+        // Requested device, -1 for any
+        int device = -1;
+        SweepCalibration calibration = SweepCalibration::Device;
+        // `Calibration::getVersion` for host calibrated sweeps, so sweeps of a replaced calibration are not shared
+        uint64_t calibrationVersion = 0;
+
+        bool operator==(const SweepSpec& other) const {
+            return start == other.start && step == other.step && points == other.points && average == other.average && device == other.device &&
+                calibration == other.calibration && calibrationVersion == other.calibrationVersion;
+        }
+
+        uint8_t samplesMode() const {
+            return calibration == SweepCalibration::Device ? LITEVNA_SAMPLES_MODE_DEVICE_CALIBRATION : LITEVNA_SAMPLES_MODE_APP_CALIBRATION;
+        }
+    };
+
+    struct SweepSpecHash {
+        size_t operator()(const SweepSpec& spec) const {
+            size_t h = hash<uint64_t>()(spec.start);
+            h = h * 31 + hash<uint64_t>()(spec.step);
+            h = h * 31 + spec.points;
+            h = h * 31 + spec.average;
+            h = h * 31 + (size_t)spec.device;
+            h = h * 31 + (size_t)spec.calibration;
+            h = h * 31 + hash<uint64_t>()(spec.calibrationVersion);
+
+            return h;
+        }
+    };
+
+    class SweepEncoder;
+
+    // A client waiting for a sweep. Streaming clients receive points as soon as they are decoded.
+    struct SweepWaiter {
+        uint64_t socketId = 0;
+        bool streaming = false;
+        size_t sentPoints = 0;
+        // Output format of the response (see SweepEncoder.h)
+        shared_ptr<SweepEncoder> encoder;
+        // Time domain response (/litevna/tdr) instead of the sweep points
+        bool tdr = false;
+        TDRSpec tdrSpec;
+        // Significant digits of the time domain response, see JSONWriter
+        int tdrDigits = 0;
+    };
+
+    struct SweepJob {
+        uint64_t id = 0;
+        SweepSpec spec;
+        // Device that runs the sweep
+        size_t device = 0;
+        // Host calibration of the grid, applied by the device thread as points are decoded
+        shared_ptr<const ErrorTerms> errorTerms;
+
+        // Written by the device thread, read by the event loop thread after completion
+        ScanValues values;
+        Result result;
+
+        // Points decoded from index 0 onwards, `values` below it can be read while the sweep runs
+        atomic<size_t> contiguousPoints{ 0 };
+        // Set by the event loop when a waiter streams, so the device thread reports progress
+        atomic<bool> streaming{ false };
+
+        // Owned by the event loop thread
+        vector<SweepWaiter> waiters;
+    };
+
+    // Runs LiteVNA sweeps on a dedicated thread. Jobs are handed over through lock-free queues,
+    // so the event loop is never blocked by the serial link.
+    // With `Config::monitorPoints`, the monitor sweep runs whenever no job is queued. It is double
+    // buffered: the device thread sweeps into a spare job while readers use the latest one, and
+    // completed sweeps are published with an atomic pointer swap.
+    class SweepService {
+    public:
+        typedef function<void()> WakeupCallback;
+
+        // 1. Lifecycle
+        SweepService() = default;
+        SweepService(const SweepService&) = delete;
+        SweepService& operator=(const SweepService&) = delete;
+        SweepService(const SweepService&&) = delete;
+        SweepService& operator=(const SweepService&&) = delete;
+        ~SweepService() = default;
+
+        Result initialize() {
+            requestTerminate = false;
+
+            try {
+                deviceThread = thread(&SweepService::run, this);
+            }
+            catch (system_error& e) {
+                return Result("could_not_create_thread", "could not create thread `sweep_service`: {}", e.what());
+            }
+            return Result::ok();
+        }
+
+        void terminate() {
+            if (!deviceThread.joinable()) {
+                return;
+            }
+            {
+                lock_guard<mutex> guard(parkMutex);
+                requestTerminate = true;
+            }
+            parkCondition.notify_one();
+            deviceThread.join();
+        }
+
+        // 2. Dependency injection
+        void setConfig(Config* _config) {
+            config = _config;
+        }
+
+        void setLiteVNA(LiteVNA* _liteVNA) {
+            liteVNA = _liteVNA;
+        }
+
+        // Index of the device in the pool, only device 0 runs the background sweep
+        void setDevice(size_t _device) {
+            device = _device;
+        }
+
+        // Called from the device thread every time a job completes
+        void onWakeup(WakeupCallback callback) {
+            wakeupCallback = callback;
+        }
+
+        // 3. Functionalities (event loop thread only)
+        bool submit(shared_ptr<SweepJob> job) {
+            if (inFlight >= SWEEP_SERVICE_QUEUE_SIZE) {
+                return false;
+            }
+            if (!requests.push(job)) {
+                return false;
+            }
+            inFlight++;
+
+            {
+                lock_guard<mutex> guard(parkMutex);
+            }
+            parkCondition.notify_one();
+
+            return true;
+        }
+
+        // Hands every completed job to `callback`
+        void poll(const function<void(shared_ptr<SweepJob>)>& callback) {
+            shared_ptr<SweepJob> job;
+
+            while (completions.pop(job)) {
+                inFlight--;
+                callback(job);
+            }
+        }
+
+        size_t getInFlight() const {
+            return inFlight;
+        }
+
+        bool isMonitoring() const {
+            return device == 0 && config->monitorPoints > 0;
+        }
+
+        // Latest completed monitor sweep, or nullptr. Its values do not change while it is held.
+        shared_ptr<SweepJob> getLatest() const {
+            return atomic_load(&latest);
+        }
+
+    private:
+        Config* config = nullptr;
+        LiteVNA* liteVNA = nullptr;
+        size_t device = 0;
+        WakeupCallback wakeupCallback = nullptr;
+        thread deviceThread;
+        mutex parkMutex;
+        condition_variable parkCondition;
+        bool requestTerminate = false;
+        size_t inFlight = 0;
+
+        // In flight jobs never exceed the queue size, so completions can not overflow
+        SPSCQueue<shared_ptr<SweepJob>> requests{ SWEEP_SERVICE_QUEUE_SIZE };
+        SPSCQueue<shared_ptr<SweepJob>> completions{ SWEEP_SERVICE_QUEUE_SIZE };
+
+        // Monitor buffers, `spare` is owned by the device thread
+        shared_ptr<SweepJob> latest;
+        shared_ptr<SweepJob> spare;
+        uint64_t lastMonitorId = 0;
+
+        void run() {
+            LOGGER(LiteVNA, "Sweep service started");
+
+            while (true) {
+                shared_ptr<SweepJob> job;
+
+                if (!requests.pop(job)) {
+                    unique_lock<mutex> lock(parkMutex);
+
+                    if (!isMonitoring()) {
+                        parkCondition.wait(lock, [this]() {
+                            return requestTerminate || !requests.empty();
+                        });
+                    }
+                    if (requestTerminate) {
+                        break;
+                    }
+                    lock.unlock();
+
+                    if (isMonitoring() && requests.empty()) {
+                        monitor();
+                    }
+                    continue;
+                }
+                size_t corrected = 0;
+
+                job->result = liteVNA->scan(job->spec.start, job->spec.step, job->spec.points, job->spec.average, job->spec.samplesMode(), job->values,
+                    [this, &job, &corrected](size_t contiguousPoints) {
+                    // Points are published corrected
+                    if (job->errorTerms) {
+                        Calibration::apply(*job->errorTerms, job->values, corrected, contiguousPoints);
+                        corrected = contiguousPoints;
+                    }
+                    job->contiguousPoints.store(contiguousPoints, memory_order_release);
+
+                    if (job->streaming.load(memory_order_acquire) && wakeupCallback) {
+                        wakeupCallback();
+                    }
+                });
+
+                if (job->result) {
+                    LOGGER(Error, "Sweep {} failed: {}", job->id, job->result.toLog());
+                }
+                else if (job->errorTerms) {
+                    Calibration::apply(*job->errorTerms, job->values, corrected, job->spec.points);
+                }
+                completions.push(job);
+
+                if (wakeupCallback) {
+                    wakeupCallback();
+                }
+            }
+            LOGGER(LiteVNA, "Sweep service stopped");
+        }
+
+        void monitor() {
+            // The previous buffer is reused once the event loop released it, otherwise a new one is used
+            if (!spare || spare.use_count() > 1) {
+                spare = make_shared<SweepJob>();
+                spare->spec.start = config->monitorStart;
+                spare->spec.step = config->monitorStep;
+                spare->spec.points = config->monitorPoints;
+                spare->spec.average = config->monitorAverage;
+            }
+            spare->id = ++lastMonitorId;
+            spare->result = liteVNA->scan(spare->spec.start, spare->spec.step, spare->spec.points, spare->spec.average, spare->spec.samplesMode(), spare->values);
+
+            if (spare->result) {
+                LOGGER(Error, "Monitor sweep {} failed: {}", spare->id, spare->result.toLog());
+
+                // Retry later, unless a job arrives
+                unique_lock<mutex> lock(parkMutex);
+
+                parkCondition.wait_for(lock, chrono::milliseconds(SWEEP_SERVICE_MONITOR_RETRY_MS), [this]() {
+                    return requestTerminate || !requests.empty();
+                });
+                return;
+            }
+            spare->contiguousPoints.store(spare->spec.points, memory_order_release);
+            spare = atomic_exchange(&latest, spare);
+        }
+    };
+}
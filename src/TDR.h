@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include "lib/FFT.h"
+
+#define TDR_SPEED_OF_LIGHT  299792458.0
+#define TDR_MAX_BINS        8192
+#define TDR_MAX_FFT_SIZE    (1 << 20)
+
+namespace litevnaserver {
+    enum class TDRWindow {
+        None,
+        Hann,
+        Kaiser
+    };
+
+    enum class TDRResponse {
+        Impulse,
+        Step
+    };
+
+    struct TDRSpec {
+        TDRWindow window = TDRWindow::Kaiser;
+        double beta = 6.0;
+        TDRResponse response = TDRResponse::Impulse;
+        double velocityFactor = 0.66;
+        // Output bins between 0 and `distance` meters, 0 for the whole unambiguous range
+        size_t bins = 256;
+        double distance = 0.0;
+    };
+
+    // Time domain reflectometry: the S11 of a sweep is windowed and transformed to the reflection
+    // response against distance. Sweeps whose start equals their step are harmonic (lowpass mode):
+    // DC is extrapolated and the spectrum made Hermitian, so the response is real, signed, and the
+    // step response is available. Other sweeps (bandpass mode) give the impulse magnitude only.
+    // The FFT is zero padded to a 2, 3 and 5 smooth size for at least `bins` bins up to `distance`.
+    // Impulses are normalized to the window gain (a flat unit spectrum peaks at 1), the step response
+    // tends to the reflection coefficient. The buffers and FFT plans are reused between calls.
+    class TDR {
+    public:
+        // Distance between bins, in meters
+        double resolution = 0.0;
+        vector<float> response;
+
+        static bool isLowpass(uint64_t start, uint64_t step) {
+            return start == step;
+        }
+
+        // Round trip range of the sweep, the response repeats beyond it
+        static double unambiguousRange(uint64_t step, double velocityFactor) {
+            return velocityFactor * TDR_SPEED_OF_LIGHT / (2.0 * (double)step);
+        }
+
+        static Result validate(uint64_t start, uint64_t step, uint32_t points, const TDRSpec& spec) {
+            if (spec.response == TDRResponse::Step && !isLowpass(start, step)) {
+                return Result("tdr_error", "step response needs a sweep whose start equals its step");
+            }
+            double range = unambiguousRange(step, spec.velocityFactor);
+
+            if (spec.distance > range) {
+                return Result("tdr_error", "distance beyond the unambiguous range of {} m", range);
+            }
+            double distance = spec.distance > 0 ? spec.distance : range;
+
+            if ((double)spec.bins * range / distance > TDR_MAX_FFT_SIZE || 2.0 * (points + 1) > TDR_MAX_FFT_SIZE) {
+                return Result("tdr_error", "too many bins for the distance");
+            }
+            return Result::ok();
+        }
+
+        Result compute(const ScanValues& values, uint64_t start, uint64_t step, uint32_t points, const TDRSpec& spec) {
+            Result result = validate(start, step, points, spec);
+
+            if (result) {
+                return result;
+            }
+            const complex<float>* s11 = values.channel0In.data();
+            bool lowpass = isLowpass(start, step);
+            double range = unambiguousRange(step, spec.velocityFactor);
+            double distance = spec.distance > 0 ? spec.distance : range;
+            size_t size = FFT::goodSize(max((size_t)ceil((double)spec.bins * range / distance), lowpass ? 2 * ((size_t)points + 1) : (size_t)points));
+            double gain = 0.0;
+
+            spectrum.assign(size, complex<double>(0.0, 0.0));
+
+            if (lowpass) {
+                // Bin k is k * step, bin 0 (DC) is extrapolated and real
+                complex<double> dc = points > 1 ? 2.0 * complex<double>(s11[0]) - complex<double>(s11[1]) : complex<double>(s11[0]);
+
+                spectrum[0] = dc.real() * window(spec, 0.0);
+                gain = window(spec, 0.0);
+
+                for (size_t k = 1; k <= points; k++) {
+                    double w = window(spec, (double)k / (points + 1));
+
+                    spectrum[k] = complex<double>(s11[k - 1]) * w;
+                    spectrum[size - k] = conj(spectrum[k]);
+                    gain += 2.0 * w;
+                }
+            }
+            else {
+                for (size_t k = 0; k < points; k++) {
+                    double w = window(spec, ((double)k - (points - 1) / 2.0) / ((points + 1) / 2.0));
+
+                    spectrum[k] = complex<double>(s11[k]) * w;
+                    gain += w;
+                }
+            }
+            fft.transform(spectrum, true);
+
+            resolution = range / (double)size;
+            size_t count = min(size, (size_t)floor(distance / resolution + 1e-9) + 1);
+            response.resize(count);
+
+            if (spec.response == TDRResponse::Step) {
+                // Integrated from -range / 2, the impulses spread around 0 wrap to the end of the period
+                double sum = 0.0;
+
+                for (size_t n = size / 2; n < size; n++) {
+                    sum += spectrum[n].real() / (double)size;
+                }
+                for (size_t n = 0; n < count; n++) {
+                    sum += spectrum[n].real() / (double)size;
+                    response[n] = (float)sum;
+                }
+                return Result::ok();
+            }
+            for (size_t n = 0; n < count; n++) {
+                response[n] = (float)((lowpass ? spectrum[n].real() : abs(spectrum[n])) / gain);
+            }
+            return Result::ok();
+        }
+
+    private:
+        FFT fft;
+        vector<complex<double>> spectrum;
+
+        // Window value at `x` in [-1, 1], 1 at the center
+        static double window(const TDRSpec& spec, double x) {
+            switch (spec.window) {
+                case TDRWindow::Hann:
+                    return 0.5 * (1.0 + cos(M_PI * x));
+
+                case TDRWindow::Kaiser:
+                    return besselI0(spec.beta * sqrt(max(0.0, 1.0 - x * x))) / besselI0(spec.beta);
+
+                default:
+                    return 1.0;
+            }
+        }
+
+        // Modified Bessel function of the first kind, order 0 (power series)
+        static double besselI0(double x) {
+            double sum = 1.0;
+            double term = 1.0;
+            double half = x / 2.0;
+
+            for (int k = 1; k < 100 && term > sum * 1e-12; k++) {
+                term *= (half / k) * (half / k);
+                sum += term;
+            }
+            return sum;
+        }
+    };
+}
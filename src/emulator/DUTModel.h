@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <complex>
+#include <math.h>
+
+#define DUT_MODEL_SPEED_OF_LIGHT  299792458.0
+#define DUT_MODEL_NEPER_DB        8.685889638
+
+namespace litevnaserver {
+    using namespace std;
+
+    enum class DUTType {
+        Open,
+        Short,
+        Load,
+        Thru,
+        // Series R, L and C between port 1 and port 2, a band pass resonator
+        RLC,
+        // Lossy transmission line between port 1 and port 2
+        Line
+    };
+
+    // S11 (port 1 reflection) and S21 (port 1 to port 2 transmission), the channels a LiteVNA measures
+    struct SParameters {
+        complex<double> s11;
+        complex<double> s21;
+    };
+
+    // Synthetic device under test. Two-port models are built from their ABCD matrix, ports
+    // terminated in `referenceImpedance`.
+    struct DUTModel {
+        DUTType type = DUTType::RLC;
+        double referenceImpedance = 50.0;
+
+        // RLC: ohms, henries and farads (resonance at 1 / (2 pi sqrt(L C)))
+        double resistance = 5.0;
+        double inductance = 100e-9;
+        double capacitance = 10e-12;
+
+        // Line: characteristic impedance in ohms, length in meters, velocity factor, and loss in dB
+        // per meter at 1 GHz (skin effect, proportional to the square root of the frequency)
+        double lineImpedance = 75.0;
+        double lineLength = 1.0;
+        double velocityFactor = 0.66;
+        double lineLoss = 0.5;
+
+        SParameters evaluate(double frequency) const {
+            switch (type) {
+                case DUTType::Open:
+                    return SParameters{ 1.0, 0.0 };
+
+                case DUTType::Short:
+                    return SParameters{ -1.0, 0.0 };
+
+                case DUTType::Load:
+                    return SParameters{ 0.0, 0.0 };
+
+                case DUTType::Thru:
+                    return SParameters{ 0.0, 1.0 };
+
+                case DUTType::RLC: {
+                    double omega = 2.0 * M_PI * frequency;
+                    complex<double> z(resistance, omega * inductance - (omega > 0 ? 1.0 / (omega * capacitance) : 0.0));
+
+                    return fromABCD(1.0, z, 0.0, 1.0);
+                }
+                case DUTType::Line: {
+                    double alpha = lineLoss / DUT_MODEL_NEPER_DB * sqrt(frequency / 1e9);
+                    double beta = 2.0 * M_PI * frequency / (velocityFactor * DUT_MODEL_SPEED_OF_LIGHT);
+                    complex<double> gammaLength = complex<double>(alpha, beta) * lineLength;
+                    complex<double> c = cosh(gammaLength);
+                    complex<double> s = sinh(gammaLength);
+
+                    return fromABCD(c, lineImpedance * s, s / lineImpedance, c);
+                }
+            }
+            return SParameters{ 0.0, 0.0 };
+        }
+
+    private:
+        SParameters fromABCD(complex<double> a, complex<double> b, complex<double> c, complex<double> d) const {
+            complex<double> z0 = referenceImpedance;
+            complex<double> delta = a + b / z0 + c * z0 + d;
+
+            return SParameters{ (a + b / z0 - c * z0 - d) / delta, 2.0 / delta };
+        }
+    };
+}
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+namespace litevnaserver {
+    using namespace std;
+    using namespace makeland;
+
+    class EmulatorConfig {
+    public:
+        string version = "1.0.0";
+        string link;
+        DUTModel model;
+        double rate = 5000.0;
+        double noise = 0.0;
+
+        EmulatorConfig() = default;
+        EmulatorConfig(const EmulatorConfig&) = delete;
+        EmulatorConfig& operator=(const EmulatorConfig&) = delete;
+        EmulatorConfig(const EmulatorConfig&&) = delete;
+        EmulatorConfig& operator=(const EmulatorConfig&&) = delete;
+        ~EmulatorConfig() = default;
+
+        Result initialize(int argc, char* argv[]) {
+            Result result = parseArgs(argc, argv);
+
+            if (result) {
+                return result;
+            }
+            return Result::ok();
+        }
+
+    private:
+        Result parseArgs(int argc, char* argv[]) {
+            int i = 1;
+
+            while (i < argc) {
+                vector<string> optionValue = su::split(argv[i], '=', false);
+
+                if (optionValue[0] == "-link") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-link` requires a value. Try `litevnaemulator --help`");
+                    }
+                    link = optionValue[1];
+                }
+                else if (optionValue[0] == "-dut") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-dut` requires a value. Try `litevnaemulator --help`");
+                    }
+                    vector<string> values = su::split(optionValue[1], ',', true);
+                    string type = values.size() > 0 ? values[0] : "";
+                    bool valid = true;
+
+                    if (type == "open" && values.size() == 1) {
+                        model.type = DUTType::Open;
+                    }
+                    else if (type == "short" && values.size() == 1) {
+                        model.type = DUTType::Short;
+                    }
+                    else if (type == "load" && values.size() == 1) {
+                        model.type = DUTType::Load;
+                    }
+                    else if (type == "thru" && values.size() == 1) {
+                        model.type = DUTType::Thru;
+                    }
+                    else if (type == "rlc" && (values.size() == 1 || values.size() == 4)) {
+                        model.type = DUTType::RLC;
+
+                        if (values.size() == 4) {
+                            valid = parseDouble(values[1], model.resistance) && parseDouble(values[2], model.inductance) &&
+                                parseDouble(values[3], model.capacitance) && model.resistance >= 0 && model.inductance > 0 && model.capacitance > 0;
+                        }
+                    }
+                    else if (type == "line" && (values.size() == 1 || values.size() == 5)) {
+                        model.type = DUTType::Line;
+
+                        if (values.size() == 5) {
+                            valid = parseDouble(values[1], model.lineImpedance) && parseDouble(values[2], model.lineLength) &&
+                                parseDouble(values[3], model.velocityFactor) && parseDouble(values[4], model.lineLoss) &&
+                                model.lineImpedance > 0 && model.lineLength >= 0 && model.velocityFactor > 0 && model.velocityFactor <= 1 && model.lineLoss >= 0;
+                        }
+                    }
+                    else {
+                        valid = false;
+                    }
+                    if (!valid) {
+                        return Result("argument_error", "Invalid device under test `{}`", optionValue[1]);
+                    }
+                }
+                else if (optionValue[0] == "-rate") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-rate` requires a value. Try `litevnaemulator --help`");
+                    }
+                    if (!parseDouble(optionValue[1], rate) || rate <= 0) {
+                        return Result("argument_error", "Invalid rate `{}`", optionValue[1]);
+                    }
+                }
+                else if (optionValue[0] == "-noise") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-noise` requires a value. Try `litevnaemulator --help`");
+                    }
+                    if (!parseDouble(optionValue[1], noise) || noise < 0) {
+                        return Result("argument_error", "Invalid noise `{}`", optionValue[1]);
+                    }
+                }
+                else if (optionValue[0] == "-logger-categories") {
+                    if (optionValue.size() < 2) {
+                        return Result("argument_error", "Option `-logger-categories` requires a value. Try `litevnaemulator --help`");
+                    }
+                    uint64_t categories = 0;
+
+                    vector<string> values = su::split(optionValue[1], ',', true);
+
+                    for (auto category : values) {
+                        if (category == "info") {
+                            categories |= Logger_Category_Info;
+                        }
+                        else if (category == "error") {
+                            categories |= Logger_Category_Error;
+                        }
+                        else if (category == "lite_vna") {
+                            categories |= Logger_Category_LiteVNA;
+                        }
+                        else if (category == "all") {
+                            categories |= Logger_Category_All;
+                        }
+                        else {
+                            return Result("argument_error", "Category `{}` is invalid. Try `litevnaemulator --help`", category);
+                        }
+                    }
+                    Logger::setCategories(categories);
+                }
+                else if (optionValue[0] == "--version") {
+                    return Result("version_requested", "litevnaemulator {}\nLicense: GPL 2.0 only", version);
+                }
+                else if (optionValue[0] == "--help") {
+                    return helpRequested();
+                }
+                else {
+                    return Result("argument_error", "Option `{}` is invalid. Try `litevnaemulator --help`", optionValue[0]);
+                }
+                i++;
+            }
+            return Result::ok();
+        }
+
+        static bool parseDouble(const string& text, double& value) {
+            char* end = nullptr;
+            value = strtod(text.data(), &end);
+
+            return text.size() > 0 && end == text.data() + text.size() && isfinite(value);
+        }
+
+        Result helpRequested() {
+            return Result("help_requested",
+                R"(
+DESCRIPTION
+
+    LiteVNAEmulator emulates a LiteVNA 64 on a pseudo-terminal, for running litevnaserver without
+    a device. It answers the protocol used by litevnaserver and measures a synthetic device under
+    test at a fixed rate.
+
+USAGE
+
+    litevnaemulator [options]
+
+    Options:
+        --version                    Show version information.
+        --help                       Display this information.
+        -link=<path>                 Symbolic link to the pseudo-terminal, to be used as -com-port
+                                     (default none, the pseudo-terminal name is logged).
+        -dut=<model>                 Device under test (default rlc):
+                                       open, short, load, thru    calibration standards.
+                                       rlc[,<ohms>,<henries>,<farads>]
+                                                                  series resonator between the ports
+                                                                  (default 5,100e-9,10e-12).
+                                       line[,<ohms>,<meters>,<velocity-factor>,<dB/m at 1 GHz>]
+                                                                  lossy line between the ports
+                                                                  (default 75,1,0.66,0.5).
+        -rate=<values>               Values measured per second, points x avg (default 5000).
+        -noise=<level>               Standard deviation of the noise added to each value, relative
+                                     to the reference amplitude (default 0). The noise sequence
+                                     restarts with every sweep, so sweeps are reproducible.
+        -logger-categories=<options> Comma separated options: lite_vna,info,error,all (default info,error).
+
+    Example:
+        litevnaemulator -link=/tmp/litevna -dut=line,75,2,0.66,0.5 -rate=20000
+        litevnaserver -com-port=/tmp/litevna -tcp-port=8888
+)");
+        }
+    };
+}
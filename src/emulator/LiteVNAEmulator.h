@@ -0,0 +1,371 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include <random>
+
+#define LITEVNA_EMULATOR_REFERENCE   1000000.0
+#define LITEVNA_EMULATOR_NOISE_SEED  1
+#define LITEVNA_EMULATOR_READ_SIZE   4096
+
+namespace litevnaserver {
+    // LiteVNA 64 on a pseudo-terminal. Commands are executed in order and a Fifo read blocks the
+    // commands after it until all its values are sent, as in the device. Programming a sweep register
+    // starts a new sweep, measured at `EmulatorConfig::rate` values per second from that moment.
+    // Fifo reads beyond the end of the sweep are truncated to it. Raw values
+    // (LITEVNA_SAMPLES_MODE_APP_CALIBRATION) carry fixed error terms, see `addErrors`.
+    class LiteVNAEmulator {
+    public:
+        // 1. Lifecycle
+        LiteVNAEmulator() = default;
+        LiteVNAEmulator(const LiteVNAEmulator&) = delete;
+        LiteVNAEmulator& operator=(const LiteVNAEmulator&) = delete;
+        LiteVNAEmulator(const LiteVNAEmulator&&) = delete;
+        LiteVNAEmulator& operator=(const LiteVNAEmulator&&) = delete;
+        ~LiteVNAEmulator() = default;
+
+        Result initialize() {
+            master = posix_openpt(O_RDWR | O_NOCTTY | O_NONBLOCK);
+
+            if (master == -1) {
+                return Result("emulator_error", "Error calling method `posix_openpt`: {}", getLastError());
+            }
+            if (grantpt(master) == -1 || unlockpt(master) == -1) {
+                return Result("emulator_error", "Error unlocking pseudo-terminal: {}", getLastError());
+            }
+            string name = ptsname(master);
+
+            // Kept open so the pseudo-terminal survives clients closing it, and raw so nothing is
+            // echoed before a client configures it
+            slave = ::open(name.data(), O_RDWR | O_NOCTTY);
+
+            if (slave == -1) {
+                return Result("emulator_error", "Error opening pseudo-terminal {}: {}", name, getLastError());
+            }
+            struct termios settings;
+
+            if (tcgetattr(slave, &settings) == -1) {
+                return Result("emulator_error", "Error calling method `tcgetattr`: {}", getLastError());
+            }
+            cfmakeraw(&settings);
+            tcsetattr(slave, TCSANOW, &settings);
+
+            if (config->link.size() > 0) {
+                ::unlink(config->link.data());
+
+                if (::symlink(name.data(), config->link.data()) == -1) {
+                    return Result("emulator_error", "Error creating link {}: {}", config->link, getLastError());
+                }
+                LOGGER(Info, "Emulating LiteVNA at {} ({})", config->link, name);
+            }
+            else {
+                LOGGER(Info, "Emulating LiteVNA at {}", name);
+            }
+            registers.fill(0);
+            registers[LITEVNA_REG_VALUES_PER_FREQUENCY] = 1;
+
+            return Result::ok();
+        }
+
+        void terminate() {
+            if (master != -1) {
+                ::close(master);
+                master = -1;
+            }
+            if (slave != -1) {
+                ::close(slave);
+                slave = -1;
+            }
+            if (config != nullptr && config->link.size() > 0) {
+                ::unlink(config->link.data());
+            }
+        }
+
+        // 2. Dependency injection
+        void setConfig(EmulatorConfig* _config) {
+            config = _config;
+        }
+
+        // 3. Functionalities
+        Result run() {
+            while (true) {
+                Result result = receive();
+
+                if (result) {
+                    return result;
+                }
+                // A completed Fifo read unblocks the commands after it
+                do {
+                    execute();
+                } while (measure());
+
+                result = transmit();
+
+                if (result) {
+                    return result;
+                }
+                result = wait();
+
+                if (result) {
+                    return result;
+                }
+            }
+        }
+
+    private:
+        EmulatorConfig* config = nullptr;
+        int master = -1;
+        int slave = -1;
+        array<uint8_t, 256> registers;
+        vector<uint8_t> input;
+        vector<uint8_t> output;
+
+        uint64_t sweepStart = 0;  // Monotonic microseconds
+        size_t sent = 0;          // Values of the sweep already sent
+        size_t requested = 0;     // Values requested by Fifo reads and not sent yet
+        mt19937 noise;
+
+        Result receive() {
+            uint8_t buffer[LITEVNA_EMULATOR_READ_SIZE];
+
+            while (true) {
+                ssize_t count = ::read(master, buffer, sizeof(buffer));
+
+                if (count > 0) {
+                    LOGGER(LiteVNA, "Received{}", formatBytes(buffer, (size_t)count));
+                    input.insert(input.end(), buffer, buffer + count);
+                    continue;
+                }
+                if (count == -1 && errno != EAGAIN && errno != EINTR && errno != EIO) {
+                    return Result("emulator_error", "Error calling method `read`: {}", getLastError());
+                }
+                return Result::ok();
+            }
+        }
+
+        // Executes the received commands until a Fifo read is pending
+        void execute() {
+            size_t n = 0;
+
+            while (n < input.size() && requested == 0) {
+                uint8_t cmd = input[n];
+                size_t available = input.size() - n;
+
+                if (cmd == LITEVNA_CMD_INDICATE) {
+                    output.push_back(LITEVNA_INDICATE_RESPONSE);
+                    n += 1;
+                }
+                else if (cmd == LITEVNA_CMD_READ1 || cmd == LITEVNA_CMD_READ2 || cmd == LITEVNA_CMD_READ4) {
+                    if (available < 2) {
+                        break;
+                    }
+                    size_t size = cmd == LITEVNA_CMD_READ1 ? 1 : (cmd == LITEVNA_CMD_READ2 ? 2 : 4);
+
+                    for (size_t i = 0; i < size; i++) {
+                        output.push_back(readRegister((uint8_t)(input[n + 1] + i)));
+                    }
+                    n += 2;
+                }
+                else if (cmd >= LITEVNA_CMD_WRITE1 && cmd <= LITEVNA_CMD_WRITE8) {
+                    size_t size = (size_t)1 << (cmd - LITEVNA_CMD_WRITE1);
+
+                    if (available < 2 + size) {
+                        break;
+                    }
+                    writeRegisters(input[n + 1], input.data() + n + 2, size);
+                    n += 2 + size;
+                }
+                else if (cmd == LITEVNA_CMD_READ_FIFO) {
+                    if (available < 3) {
+                        break;
+                    }
+                    if (input[n + 1] == LITEVNA_REG_READ_FIFO) {
+                        size_t remaining = sweepValues() - sent;
+                        size_t count = input[n + 2] == LITEVNA_SEND_ALL_POINTS ? remaining : min<size_t>(input[n + 2], remaining);
+
+                        requested = count;
+                    }
+                    n += 3;
+                }
+                else {
+                    // No operation (LITEVNA_CLEAR_FIFO) and unknown commands
+                    n += 1;
+                }
+            }
+            input.erase(input.begin(), input.begin() + n);
+        }
+
+        uint8_t readRegister(uint8_t address) const {
+            if (address == LITEVNA_REG_DEVICE_VARIANT) {
+                return LITEVNA_DEVICE_VARIANT;
+            }
+            if (address == LITEVNA_REG_PROTOCOL_VERSION) {
+                return LITEVNA_PROTOCOL_VERSION;
+            }
+            return registers[address];
+        }
+
+        void writeRegisters(uint8_t address, const uint8_t* values, size_t size) {
+            for (size_t i = 0; i < size; i++) {
+                registers[(uint8_t)(address + i)] = values[i];
+            }
+            switch (address) {
+                case LITEVNA_REG_SWEEP_START:
+                case LITEVNA_REG_SWEEP_STEP:
+                case LITEVNA_REG_SWEEP_POINTS:
+                case LITEVNA_REG_VALUES_PER_FREQUENCY:
+                case LITEVNA_REG_READ_FIFO:
+                    restart();
+                    break;
+
+                default:
+                    break;
+            }
+        }
+
+        void restart() {
+            sweepStart = DateTime::monotonicMicroseconds();
+            sent = 0;
+            requested = 0;
+            noise.seed(LITEVNA_EMULATOR_NOISE_SEED);
+        }
+
+        uint64_t registerValue(uint8_t address, size_t size) const {
+            uint64_t value = 0;
+
+            for (size_t i = 0; i < size; i++) {
+                value |= (uint64_t)registers[address + i] << (i * 8);
+            }
+            return value;
+        }
+
+        size_t valuesPerFrequency() const {
+            return max<size_t>(1, (size_t)registerValue(LITEVNA_REG_VALUES_PER_FREQUENCY, 2));
+        }
+
+        size_t sweepValues() const {
+            return (size_t)registerValue(LITEVNA_REG_SWEEP_POINTS, 2) * valuesPerFrequency();
+        }
+
+        // Sends the requested values measured so far, returns true if a Fifo read completed
+        bool measure() {
+            if (requested == 0) {
+                return false;
+            }
+            uint64_t elapsed = DateTime::monotonicMicroseconds() - sweepStart;
+            size_t measured = min(sweepValues(), (size_t)(elapsed * config->rate / 1e6));
+
+            while (requested > 0 && sent < measured) {
+                appendValue(sent);
+                sent++;
+                requested--;
+            }
+            return requested == 0;
+        }
+
+        void appendValue(size_t index) {
+            size_t point = index / valuesPerFrequency();
+            double frequency = (double)registerValue(LITEVNA_REG_SWEEP_START, 8) + (double)registerValue(LITEVNA_REG_SWEEP_STEP, 8) * point;
+            SParameters s = config->model.evaluate(frequency);
+
+            if (registers[LITEVNA_REG_SAMPLES_MODE] == LITEVNA_SAMPLES_MODE_APP_CALIBRATION) {
+                s = addErrors(frequency, s);
+            }
+
+            // The reference phase rotates with frequency, as the device's does not stay constant
+            complex<double> reference = polar(LITEVNA_EMULATOR_REFERENCE, fmod(frequency * 1e-8, 2.0 * M_PI));
+            complex<double> in0 = s.s11 * reference;
+            complex<double> in1 = s.s21 * reference;
+
+            if (config->noise > 0) {
+                normal_distribution<double> distribution(0.0, config->noise * LITEVNA_EMULATOR_REFERENCE);
+
+                in0 += complex<double>(distribution(noise), distribution(noise));
+                in1 += complex<double>(distribution(noise), distribution(noise));
+            }
+            LiteVNAFifoData data;
+            memset(&data, 0, sizeof(data));
+
+            data.channel0OutRe = (int32_t)lround(reference.real());
+            data.channel0OutIm = (int32_t)lround(reference.imag());
+            data.channel0InRe = (int32_t)lround(in0.real());
+            data.channel0InIm = (int32_t)lround(in0.imag());
+            data.channel1InRe = (int32_t)lround(in1.real());
+            data.channel1InIm = (int32_t)lround(in1.imag());
+            data.freqIndex = (uint16_t)point;
+            data.checksum = FifoDecoder::checksum((const uint8_t*)&data);
+
+            const uint8_t* bytes = (const uint8_t*)&data;
+            output.insert(output.end(), bytes, bytes + sizeof(data));
+        }
+
+        // Port 1 with directivity, source match and reflection tracking behind a 1 ns cable, port 1 to
+        // port 2 leakage and transmission tracking. Port 2 is matched.
+        static SParameters addErrors(double frequency, const SParameters& s) {
+            double delay = 2.0 * M_PI * frequency * 1e-9;
+            complex<double> e00 = polar(0.05, -0.3 * delay);
+            complex<double> e11 = polar(0.1, -0.7 * delay);
+            complex<double> e10e01 = polar(0.9, -2.0 * delay);
+            complex<double> e30 = polar(1e-3, delay);
+            complex<double> e10e32 = polar(0.8, -1.5 * delay);
+            complex<double> mismatch = 1.0 - e11 * s.s11;
+
+            return SParameters{ e00 + e10e01 * s.s11 / mismatch, e30 + e10e32 * s.s21 / mismatch };
+        }
+
+        Result transmit() {
+            while (output.size() > 0) {
+                ssize_t count = ::write(master, output.data(), output.size());
+
+                if (count == -1) {
+                    if (errno == EAGAIN || errno == EINTR) {
+                        break;
+                    }
+                    return Result("emulator_error", "Error calling method `write`: {}", getLastError());
+                }
+                output.erase(output.begin(), output.begin() + count);
+            }
+            return Result::ok();
+        }
+
+        // Until a command arrives, the output can be written, or the next requested value is measured
+        Result wait() {
+            int timeout = -1;
+
+            if (requested > 0) {
+                uint64_t due = sweepStart + (uint64_t)((sent + 1) * 1e6 / config->rate);
+                uint64_t now = DateTime::monotonicMicroseconds();
+
+                timeout = due > now ? (int)((due - now + 999) / 1000) : 0;
+            }
+            struct pollfd descriptor;
+            descriptor.fd = master;
+            descriptor.events = (short)(POLLIN | (output.size() > 0 ? POLLOUT : 0));
+            descriptor.revents = 0;
+
+            if (::poll(&descriptor, 1, timeout) == -1 && errno != EINTR) {
+                return Result("emulator_error", "Error calling method `poll`: {}", getLastError());
+            }
+            return Result::ok();
+        }
+
+        string formatBytes(const uint8_t* buffer, size_t size) {
+            string hex;
+
+            for (size_t n = 0; n < size; n++) {
+                hex += " " + su::toHex(buffer[n], 2);
+            }
+            return hex;
+        }
+
+        string getLastError() {
+            return su::format("errno={} ({})", errno, strerror(errno));
+        }
+    };
+}
@@ -0,0 +1,82 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#ifndef __linux__
+#error LiteVNAEmulator needs Linux pseudo-terminals
+#endif
+
+#include <stdint.h>
+#include <array>
+#include <memory>
+
+#include "lib/LoggerConsole.h"
+#include "lib/DateTime.h"
+
+#include "LoggerLiteVNAServer.h"
+#include "LiteVNAProtocol.h"
+#include "FifoDecoder.h"
+#include "emulator/DUTModel.h"
+#include "emulator/EmulatorConfig.h"
+#include "emulator/LiteVNAEmulator.h"
+
+using namespace litevnaserver;
+using namespace makeland;
+
+class Main {
+public:
+    int execute(int argc, char* argv[]) {
+        // Dependency injection
+        emulator->setConfig(config.get());
+
+        // Initialization
+        LoggerLiteVNAServer::initialize();
+        Logger::instance.setNext(loggerConsole.get());
+
+        Result result = config->initialize(argc, argv);
+
+        if (result) {
+            printf("\n%s\n", result.description.data());
+            terminate();
+
+            return -1;
+        }
+        LOGGER(Info, "litevnaemulator version: {}", config->version);
+
+        result = emulator->initialize();
+
+        if (result) {
+            LOGGER(Error, result.toLog());
+            terminate();
+
+            return -1;
+        }
+
+        // Execution
+        result = emulator->run();
+
+        if (result) {
+            LOGGER(Error, result.toLog());
+            terminate();
+
+            return -1;
+        }
+
+        // Termination
+        terminate();
+
+        return 0;
+    }
+
+    void terminate() {
+        emulator->terminate();
+    }
+
+private:
+    unique_ptr<Logger> loggerConsole = make_unique<LoggerConsole>();
+    unique_ptr<EmulatorConfig> config = make_unique<EmulatorConfig>();
+    unique_ptr<LiteVNAEmulator> emulator = make_unique<LiteVNAEmulator>();
+};
+
+int main(int argc, char* argv[]) {
+    return Main().execute(argc, argv);
+}
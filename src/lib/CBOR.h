@@ -0,0 +1,91 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+#define CBOR_MAJOR_BYTES    2
+#define CBOR_MAJOR_TEXT     3
+#define CBOR_MAJOR_MAP      5
+#define CBOR_MAJOR_TAG      6
+
+#define CBOR_FALSE   0xF4
+#define CBOR_TRUE    0xF5
+
+// Typed arrays (RFC 8746)
+#define CBOR_TAG_UINT64_LE  71
+#define CBOR_TAG_FLOAT32_LE 85
+
+namespace makeland {
+    using namespace std;
+
+    // CBOR (RFC 8949) writer with definite lengths, appending to a buffer. Typed arrays are copied in
+    // the host byte order, so their little-endian tags are only right on little-endian hosts.
+    class CBOR {
+    public:
+        static void appendBool(string& out, bool value) {
+            out += (char)(value ? CBOR_TRUE : CBOR_FALSE);
+        }
+
+        static void appendText(string& out, const char* text) {
+            size_t size = strlen(text);
+
+            appendHead(out, CBOR_MAJOR_TEXT, size);
+            out.append(text, size);
+        }
+
+        static void appendMap(string& out, size_t size) {
+            appendHead(out, CBOR_MAJOR_MAP, size);
+        }
+
+        static void appendTag(string& out, uint64_t tag) {
+            appendHead(out, CBOR_MAJOR_TAG, tag);
+        }
+
+        // Head of a byte string, its `size` bytes are appended by the caller
+        static void appendBytesHead(string& out, size_t size) {
+            appendHead(out, CBOR_MAJOR_BYTES, size);
+        }
+
+        static void appendFloat32Array(string& out, const float* values, size_t count) {
+            appendTag(out, CBOR_TAG_FLOAT32_LE);
+            appendBytesHead(out, count * sizeof(float));
+            out.append((const char*)values, count * sizeof(float));
+        }
+
+    private:
+        // Major type and argument, in the shortest form
+        static void appendHead(string& out, uint8_t major, uint64_t value) {
+            uint8_t type = (uint8_t)(major << 5);
+
+            if (value < 24) {
+                out += (char)(type | value);
+            }
+            else if (value <= 0xFF) {
+                out += (char)(type | 24);
+                out += (char)value;
+            }
+            else if (value <= 0xFFFF) {
+                out += (char)(type | 25);
+                appendBigEndian(out, value, 2);
+            }
+            else if (value <= 0xFFFFFFFF) {
+                out += (char)(type | 26);
+                appendBigEndian(out, value, 4);
+            }
+            else {
+                out += (char)(type | 27);
+                appendBigEndian(out, value, 8);
+            }
+        }
+
+        static void appendBigEndian(string& out, uint64_t value, size_t size) {
+            for (size_t n = size; n > 0; n--) {
+                out += (char)((value >> ((n - 1) * 8)) & 0xFF);
+            }
+        }
+    };
+}
@@ -246,6 +246,15 @@ namespace makeland {
             return (uint64_t)chrono::duration_cast<chrono::microseconds>(chrono::system_clock::now().time_since_epoch()).count();
         }
 
+        // Milliseconds of a clock that never goes back, for deadlines. Not related to the Unix time.
+        static uint64_t monotonicMilliseconds() {
+            return (uint64_t)chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
+        static uint64_t monotonicMicroseconds() {
+            return (uint64_t)chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+        }
+
         static uint64_t nowNanoseconds() {
             return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(chrono::system_clock::now().time_since_epoch()).count();
         }
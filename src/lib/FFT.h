@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <complex>
+#include <math.h>
+#include <unordered_map>
+#include <vector>
+
+#define FFT_MAX_PLANS 16
+
+namespace makeland {
+    using namespace std;
+
+    // Mixed radix FFT, recursive decimation in time with radix 4, 2 and generic odd radix butterflies
+    // (3, 5, or any prime factor, at O(n p) for a factor p). The factorization and the twiddle factors
+    // of each size are computed once and kept for the last FFT_MAX_PLANS sizes. Not thread-safe.
+    class FFT {
+    public:
+        FFT() = default;
+        FFT(const FFT&) = delete;
+        FFT& operator=(const FFT&) = delete;
+        FFT(const FFT&&) = delete;
+        FFT& operator=(const FFT&&) = delete;
+        ~FFT() = default;
+
+        // Transforms `data` in place: X[k] = sum x[n] e^(-2 pi i k n / N), or e^(+2 pi i k n / N) if
+        // `inverse`. The inverse is not scaled by 1 / N.
+        void transform(vector<complex<double>>& data, bool inverse) {
+            size_t size = data.size();
+
+            if (size <= 1) {
+                return;
+            }
+            const Plan& plan = getPlan(size);
+
+            input.assign(data.begin(), data.end());
+            work(data.data(), input.data(), 1, plan.factors.data(), inverse ? plan.inverse : plan.forward, inverse);
+        }
+
+        // Smallest size >= `size` whose only prime factors are 2, 3 and 5
+        static size_t goodSize(size_t size) {
+            size_t n = size > 1 ? size : 1;
+
+            while (true) {
+                size_t m = n;
+
+                for (size_t p : { 2, 3, 5 }) {
+                    while (m % p == 0) {
+                        m /= p;
+                    }
+                }
+                if (m == 1) {
+                    return n;
+                }
+                n++;
+            }
+        }
+
+    private:
+        struct Plan {
+            // Pairs of radix and remaining size, outermost stage first
+            vector<size_t> factors;
+            vector<complex<double>> forward;
+            vector<complex<double>> inverse;
+        };
+
+        unordered_map<size_t, Plan> plans;
+        vector<complex<double>> input;
+        vector<complex<double>> scratch;
+
+        const Plan& getPlan(size_t size) {
+            auto it = plans.find(size);
+
+            if (it != plans.end()) {
+                return it->second;
+            }
+            if (plans.size() >= FFT_MAX_PLANS) {
+                plans.clear();
+            }
+            Plan& plan = plans[size];
+            plan.forward.resize(size);
+            plan.inverse.resize(size);
+
+            for (size_t k = 0; k < size; k++) {
+                double angle = -2.0 * M_PI * (double)k / (double)size;
+
+                plan.forward[k] = complex<double>(cos(angle), sin(angle));
+                plan.inverse[k] = conj(plan.forward[k]);
+            }
+            size_t remaining = size;
+            size_t p = 4;
+
+            while (remaining > 1) {
+                while (remaining % p != 0) {
+                    p = p == 4 ? 2 : (p == 2 ? 3 : p + 2);
+
+                    if (p * p > remaining) {
+                        p = remaining;
+                    }
+                }
+                remaining /= p;
+                plan.factors.push_back(p);
+                plan.factors.push_back(remaining);
+            }
+            return plan;
+        }
+
+        // Transforms the `p * m` inputs taken every `stride` into `out`: each of the p interleaved
+        // subsequences is transformed into a block of m outputs, then they are combined by the butterflies
+        void work(complex<double>* out, const complex<double>* in, size_t stride, const size_t* factors, const vector<complex<double>>& twiddles, bool inverse) {
+            size_t p = factors[0];
+            size_t m = factors[1];
+
+            if (m == 1) {
+                for (size_t q = 0; q < p; q++) {
+                    out[q] = in[q * stride];
+                }
+            }
+            else {
+                for (size_t q = 0; q < p; q++) {
+                    work(out + q * m, in + q * stride, stride * p, factors + 2, twiddles, inverse);
+                }
+            }
+            switch (p) {
+                case 2:
+                    butterfly2(out, stride, twiddles, m);
+                    break;
+
+                case 4:
+                    butterfly4(out, stride, twiddles, m, inverse);
+                    break;
+
+                default:
+                    butterflyGeneric(out, stride, twiddles, m, p);
+                    break;
+            }
+        }
+
+        static void butterfly2(complex<double>* out, size_t stride, const vector<complex<double>>& twiddles, size_t m) {
+            for (size_t k = 0; k < m; k++) {
+                complex<double> t = out[k + m] * twiddles[k * stride];
+
+                out[k + m] = out[k] - t;
+                out[k] += t;
+            }
+        }
+
+        static void butterfly4(complex<double>* out, size_t stride, const vector<complex<double>>& twiddles, size_t m, bool inverse) {
+            for (size_t k = 0; k < m; k++) {
+                complex<double> s0 = out[k + m] * twiddles[k * stride];
+                complex<double> s1 = out[k + 2 * m] * twiddles[2 * k * stride];
+                complex<double> s2 = out[k + 3 * m] * twiddles[3 * k * stride];
+                complex<double> s5 = out[k] - s1;
+                complex<double> s3 = s0 + s2;
+                complex<double> s4 = s0 - s2;
+
+                out[k] += s1;
+                out[k + 2 * m] = out[k] - s3;
+                out[k] += s3;
+
+                // s4 rotated by -i (forward) or +i (inverse)
+                complex<double> r = inverse ? complex<double>(-s4.imag(), s4.real()) : complex<double>(s4.imag(), -s4.real());
+
+                out[k + m] = s5 + r;
+                out[k + 3 * m] = s5 - r;
+            }
+        }
+
+        void butterflyGeneric(complex<double>* out, size_t stride, const vector<complex<double>>& twiddles, size_t m, size_t p) {
+            size_t size = twiddles.size();
+            scratch.resize(p);
+
+            for (size_t u = 0; u < m; u++) {
+                for (size_t q = 0; q < p; q++) {
+                    scratch[q] = out[u + q * m];
+                }
+                for (size_t q = 0; q < p; q++) {
+                    size_t k = u + q * m;
+                    size_t index = 0;
+                    complex<double> sum = scratch[0];
+
+                    for (size_t r = 1; r < p; r++) {
+                        index += stride * k;
+                        index %= size;
+                        sum += scratch[r] * twiddles[index];
+                    }
+                    out[k] = sum;
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <stdint.h>
+#include <math.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define FAST_MATH_SSE2
+#include <emmintrin.h>
+#endif
+
+#define FAST_MATH_LN2     0.693147180559945f
+#define FAST_MATH_SQRT2   1.414213562373095f
+#define FAST_MATH_PI      3.141592653589793f
+#define FAST_MATH_PI_2    1.570796326794897f
+
+namespace makeland {
+    // Polynomial approximations of `logf` and `atan2f` for finite arguments, with a scalar version
+    // and an SSE2 version (4 lanes) computing exactly the same operations.
+    //   log:   mantissa reduced to [sqrt(0.5), sqrt(2)), Cephes degree 9 polynomial, relative error
+    //          below 2e-7 for normal positive arguments. 0 returns -inf.
+    //   atan2: argument reduced to [0, 1], odd minimax polynomial of degree 11, absolute error below
+    //          2e-6 radians. atan2(0, 0) returns 0, the sign of zero is ignored.
+    class FastMath {
+    public:
+        static float log(float x) {
+            if (x == 0.0f) {
+                return -INFINITY;
+            }
+            uint32_t bits;
+            memcpy(&bits, &x, sizeof(bits));
+
+            float exponent = (float)((int32_t)(bits >> 23) - 127);
+            bits = (bits & 0x007FFFFF) | 0x3F800000;
+
+            float m;
+            memcpy(&m, &bits, sizeof(m));
+
+            if (m > FAST_MATH_SQRT2) {
+                m *= 0.5f;
+                exponent += 1.0f;
+            }
+            float f = m - 1.0f;
+            float z = f * f;
+
+            return f + f * z * logPolynomial(f) - 0.5f * z + exponent * FAST_MATH_LN2;
+        }
+
+        static float atan2(float y, float x) {
+            float ax = fabsf(x);
+            float ay = fabsf(y);
+            float maximum = ax > ay ? ax : ay;
+            float minimum = ax > ay ? ay : ax;
+            float a = maximum == 0.0f ? 0.0f : minimum / maximum;
+            float r = a * atanPolynomial(a * a);
+
+            if (ay > ax) {
+                r = FAST_MATH_PI_2 - r;
+            }
+            if (x < 0.0f) {
+                r = FAST_MATH_PI - r;
+            }
+            return y < 0.0f ? -r : r;
+        }
+
+#ifdef FAST_MATH_SSE2
+        static __m128 log(__m128 x) {
+            __m128i bits = _mm_castps_si128(x);
+            __m128 exponent = _mm_cvtepi32_ps(_mm_sub_epi32(_mm_srli_epi32(bits, 23), _mm_set1_epi32(127)));
+            __m128 m = _mm_castsi128_ps(_mm_or_si128(_mm_and_si128(bits, _mm_set1_epi32(0x007FFFFF)), _mm_set1_epi32(0x3F800000)));
+
+            __m128 above = _mm_cmpgt_ps(m, _mm_set1_ps(FAST_MATH_SQRT2));
+            m = select(above, _mm_mul_ps(m, _mm_set1_ps(0.5f)), m);
+            exponent = _mm_add_ps(exponent, _mm_and_ps(above, _mm_set1_ps(1.0f)));
+
+            __m128 f = _mm_sub_ps(m, _mm_set1_ps(1.0f));
+            __m128 z = _mm_mul_ps(f, f);
+            __m128 r = _mm_add_ps(f, _mm_mul_ps(_mm_mul_ps(f, z), logPolynomial(f)));
+            r = _mm_sub_ps(r, _mm_mul_ps(_mm_set1_ps(0.5f), z));
+            r = _mm_add_ps(r, _mm_mul_ps(exponent, _mm_set1_ps(FAST_MATH_LN2)));
+
+            return select(_mm_cmpeq_ps(x, _mm_setzero_ps()), _mm_set1_ps(-INFINITY), r);
+        }
+
+        static __m128 atan2(__m128 y, __m128 x) {
+            const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+            const __m128 zero = _mm_setzero_ps();
+            __m128 ax = _mm_and_ps(x, absMask);
+            __m128 ay = _mm_and_ps(y, absMask);
+            __m128 maximum = _mm_max_ps(ax, ay);
+            __m128 minimum = _mm_min_ps(ax, ay);
+            __m128 a = _mm_andnot_ps(_mm_cmpeq_ps(maximum, zero), _mm_div_ps(minimum, maximum));
+            __m128 r = _mm_mul_ps(a, atanPolynomial(_mm_mul_ps(a, a)));
+
+            r = select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(FAST_MATH_PI_2), r), r);
+            r = select(_mm_cmplt_ps(x, zero), _mm_sub_ps(_mm_set1_ps(FAST_MATH_PI), r), r);
+
+            return select(_mm_cmplt_ps(y, zero), _mm_sub_ps(zero, r), r);
+        }
+
+        static __m128 select(__m128 mask, __m128 a, __m128 b) {
+            return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+        }
+#endif
+
+    private:
+        static float logPolynomial(float f) {
+            float p = 7.0376836292E-2f;
+            p = p * f - 1.1514610310E-1f;
+            p = p * f + 1.1676998740E-1f;
+            p = p * f - 1.2420140846E-1f;
+            p = p * f + 1.4249322787E-1f;
+            p = p * f - 1.6668057665E-1f;
+            p = p * f + 2.0000714765E-1f;
+            p = p * f - 2.4999993993E-1f;
+            p = p * f + 3.3333331174E-1f;
+
+            return p;
+        }
+
+        static float atanPolynomial(float a2) {
+            float p = -0.01172120f;
+            p = p * a2 + 0.05265332f;
+            p = p * a2 - 0.11643287f;
+            p = p * a2 + 0.19354346f;
+            p = p * a2 - 0.33262347f;
+            p = p * a2 + 0.99997726f;
+
+            return p;
+        }
+
+#ifdef FAST_MATH_SSE2
+        static __m128 logPolynomial(__m128 f) {
+            __m128 p = _mm_set1_ps(7.0376836292E-2f);
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(-1.1514610310E-1f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.1676998740E-1f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(-1.2420140846E-1f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(1.4249322787E-1f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(-1.6668057665E-1f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(2.0000714765E-1f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(-2.4999993993E-1f));
+            p = _mm_add_ps(_mm_mul_ps(p, f), _mm_set1_ps(3.3333331174E-1f));
+
+            return p;
+        }
+
+        static __m128 atanPolynomial(__m128 a2) {
+            __m128 p = _mm_set1_ps(-0.01172120f);
+            p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(0.05265332f));
+            p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(-0.11643287f));
+            p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(0.19354346f));
+            p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(-0.33262347f));
+            p = _mm_add_ps(_mm_mul_ps(p, a2), _mm_set1_ps(0.99997726f));
+
+            return p;
+        }
+#endif
+    };
+}
@@ -0,0 +1,53 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+
+namespace makeland {
+    // IEEE 754 half precision (binary16) conversion, rounded to nearest even. Values beyond 65504
+    // become infinity, values below 2^-24 become zero, NaN stays NaN.
+    class Float16 {
+    public:
+        static uint16_t fromFloat(float value) {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+
+            uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+            uint32_t exponent = (bits >> 23) & 0xFF;
+            uint32_t mantissa = bits & 0x007FFFFF;
+
+            if (exponent == 0xFF) {
+                return (uint16_t)(sign | 0x7C00 | (mantissa != 0 ? 0x0200 : 0));
+            }
+            int32_t halfExponent = (int32_t)exponent - 127 + 15;
+
+            if (halfExponent >= 31) {
+                return (uint16_t)(sign | 0x7C00);
+            }
+            if (halfExponent <= 0) {
+                if (halfExponent < -10) {
+                    return sign;
+                }
+                // Subnormal, the implicit bit becomes explicit
+                return (uint16_t)(sign | round(mantissa | 0x00800000, (uint32_t)(14 - halfExponent)));
+            }
+            // A rounding carry into the exponent is still the right result, up to infinity
+            return (uint16_t)(sign | (((uint32_t)halfExponent << 10) + round(mantissa, 13)));
+        }
+
+    private:
+        static uint32_t round(uint32_t value, uint32_t shift) {
+            uint32_t result = value >> shift;
+            uint32_t rest = value & ((1u << shift) - 1);
+            uint32_t halfway = 1u << (shift - 1);
+
+            if (rest > halfway || (rest == halfway && (result & 1) != 0)) {
+                result++;
+            }
+            return result;
+        }
+    };
+}
@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <algorithm>
+#include <math.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string>
+
+// Enough to read back any float
+#define JSON_WRITER_MAX_DIGITS 9
+
+namespace makeland {
+    using namespace std;
+
+    // Appends JSON values to a buffer, without temporary strings or streams. Floats are written with
+    // `digits` significant digits as printf's "%g" does, or with the fewest digits that read back as
+    // the same float if `digits` is 0. Non-finite floats, which JSON lacks, are written as null.
+    // Strings are quoted and escaped, other UTF-8 bytes are copied as they are.
+    class JSONWriter {
+    public:
+        // String literals, their size is known at compile time
+        template<size_t N>
+        static void appendLiteral(string& out, const char(&text)[N]) {
+            out.append(text, N - 1);
+        }
+
+        static void appendBool(string& out, bool value) {
+            if (value) {
+                appendLiteral(out, "true");
+                return;
+            }
+            appendLiteral(out, "false");
+        }
+
+        static void appendUnsigned(string& out, uint64_t value) {
+            char buffer[20];
+            char* p = buffer + sizeof(buffer);
+
+            // Two digits per division
+            while (value >= 100) {
+                const char* pair = digitPairs() + (value % 100) * 2;
+                value /= 100;
+                *--p = pair[1];
+                *--p = pair[0];
+            }
+            if (value >= 10) {
+                const char* pair = digitPairs() + value * 2;
+                *--p = pair[1];
+                *--p = pair[0];
+            }
+            else {
+                *--p = (char)('0' + value);
+            }
+            out.append(p, (size_t)(buffer + sizeof(buffer) - p));
+        }
+
+        static void appendString(string& out, const string& text) {
+            static const char hex[] = "0123456789abcdef";
+
+            out += '"';
+
+            for (char c : text) {
+                switch (c) {
+                    case '"':
+                        appendLiteral(out, "\\\"");
+                        break;
+
+                    case '\\':
+                        appendLiteral(out, "\\\\");
+                        break;
+
+                    case '\n':
+                        appendLiteral(out, "\\n");
+                        break;
+
+                    case '\r':
+                        appendLiteral(out, "\\r");
+                        break;
+
+                    case '\t':
+                        appendLiteral(out, "\\t");
+                        break;
+
+                    default:
+                        // Other control characters as \u escapes
+                        if ((unsigned char)c < 0x20) {
+                            appendLiteral(out, "\\u00");
+                            out += hex[(unsigned char)c >> 4];
+                            out += hex[c & 0x0F];
+                        }
+                        else {
+                            out += c;
+                        }
+                        break;
+                }
+            }
+            out += '"';
+        }
+
+        static void appendFloat(string& out, float value, int digits) {
+            if (!isfinite(value)) {
+                appendLiteral(out, "null");
+                return;
+            }
+            if (signbit(value)) {
+                out += '-';
+                value = -value;
+            }
+            if (value == 0.0f) {
+                out += '0';
+                return;
+            }
+            int precision = digits > 0 ? min(digits, JSON_WRITER_MAX_DIGITS) : 1;
+            int magnitude = (int)floor(log10((double)value));
+            int exponent = magnitude;
+            uint64_t mantissa = 0;
+
+            // Digits of the value rounded to `precision` digits, the mantissa has exactly `precision` digits
+            for (; precision <= JSON_WRITER_MAX_DIGITS; precision++) {
+                exponent = magnitude;
+                mantissa = round(value, precision, exponent);
+
+                if (mantissa >= power10(precision)) {
+                    exponent++;
+                    mantissa = round(value, precision, exponent);
+                }
+                else if (mantissa < power10(precision - 1)) {
+                    exponent--;
+                    mantissa = round(value, precision, exponent);
+                }
+                if (digits > 0 || precision == JSON_WRITER_MAX_DIGITS || (float)scale((double)mantissa, exponent - precision + 1) == value) {
+                    break;
+                }
+            }
+
+            // "%g" uses the scientific notation below 1e-4 and from 10^precision
+            bool scientific = exponent < -4 || exponent >= (digits > 0 ? precision : JSON_WRITER_MAX_DIGITS);
+
+            while (precision > 1 && mantissa % 10 == 0) {
+                mantissa /= 10;
+                precision--;
+            }
+            char buffer[JSON_WRITER_MAX_DIGITS];
+
+            for (int n = precision - 1; n >= 0; n--) {
+                buffer[n] = (char)('0' + mantissa % 10);
+                mantissa /= 10;
+            }
+            if (scientific) {
+                out += buffer[0];
+
+                if (precision > 1) {
+                    out += '.';
+                    out.append(buffer + 1, (size_t)(precision - 1));
+                }
+                out += 'e';
+                out += exponent < 0 ? '-' : '+';
+
+                if (abs(exponent) < 10) {
+                    out += '0';
+                }
+                appendUnsigned(out, (uint64_t)abs(exponent));
+                return;
+            }
+            if (exponent < 0) {
+                out += "0.";
+                out.append((size_t)(-exponent - 1), '0');
+                out.append(buffer, (size_t)precision);
+                return;
+            }
+            if (precision <= exponent + 1) {
+                out.append(buffer, (size_t)precision);
+                out.append((size_t)(exponent + 1 - precision), '0');
+                return;
+            }
+            out.append(buffer, (size_t)(exponent + 1));
+            out += '.';
+            out.append(buffer + exponent + 1, (size_t)(precision - exponent - 1));
+        }
+
+    private:
+        static const char* digitPairs() {
+            return "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+                "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+                "8081828384858687888990919293949596979899";
+        }
+
+        static uint64_t power10(int n) {
+            uint64_t result = 1;
+
+            while (n-- > 0) {
+                result *= 10;
+            }
+            return result;
+        }
+
+        // `value` * 10^`n`, exact powers of ten up to 10^22. The double result is far more precise
+        // than a float, so rounding it gives the float's decimal digits.
+        static double scale(double value, int n) {
+            static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+            while (n > 22) {
+                value *= 1e22;
+                n -= 22;
+            }
+            while (n < -22) {
+                value /= 1e22;
+                n += 22;
+            }
+            return n >= 0 ? value * powers[n] : value / powers[-n];
+        }
+
+        // `precision` significant digits of `value`, whose first digit has the weight 10^`exponent`.
+        // Ties go to even as in printf, floats with few significant bits scale exactly.
+        static uint64_t round(float value, int precision, int exponent) {
+            return (uint64_t)nearbyint(scale((double)value, precision - 1 - exponent));
+        }
+    };
+}
@@ -0,0 +1,89 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+
+namespace makeland {
+    using namespace std;
+
+    // Single threaded byte ring buffer. Capacity is rounded up to a power of two so positions
+    // can grow freely and be masked on access.
+    class RingBuffer {
+    public:
+        explicit RingBuffer(size_t _capacity) {
+            size_t capacity = 1;
+
+            while (capacity < _capacity) {
+                capacity <<= 1;
+            }
+            buffer.resize(capacity);
+            mask = capacity - 1;
+        }
+
+        RingBuffer(const RingBuffer&) = delete;
+        RingBuffer& operator=(const RingBuffer&) = delete;
+        RingBuffer(const RingBuffer&&) = delete;
+        RingBuffer& operator=(const RingBuffer&&) = delete;
+        ~RingBuffer() = default;
+
+        size_t capacity() const {
+            return buffer.size();
+        }
+
+        size_t size() const {
+            return writePos - readPos;
+        }
+
+        size_t freeSpace() const {
+            return capacity() - size();
+        }
+
+        void clear() {
+            readPos = 0;
+            writePos = 0;
+        }
+
+        // Contiguous free region at the write position. Call `commitWrite` with the amount filled.
+        uint8_t* writeRegion(size_t* regionSize) {
+            size_t offset = writePos & mask;
+            *regionSize = min(freeSpace(), capacity() - offset);
+
+            return buffer.data() + offset;
+        }
+
+        void commitWrite(size_t amount) {
+            writePos += amount;
+        }
+
+        // Contiguous readable region at the read position. Call `consume` with the amount used.
+        const uint8_t* readRegion(size_t* regionSize) const {
+            size_t offset = readPos & mask;
+            *regionSize = min(size(), capacity() - offset);
+
+            return buffer.data() + offset;
+        }
+
+        // Copies `amount` bytes from the read position, handling wrap around
+        void peek(uint8_t* dest, size_t amount) const {
+            size_t offset = readPos & mask;
+            size_t first = min(amount, capacity() - offset);
+
+            memcpy(dest, buffer.data() + offset, first);
+            memcpy(dest + first, buffer.data(), amount - first);
+        }
+
+        void consume(size_t amount) {
+            readPos += amount;
+        }
+
+    private:
+        vector<uint8_t> buffer;
+        size_t mask = 0;
+        size_t readPos = 0;
+        size_t writePos = 0;
+    };
+}
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <stdint.h>
+#include <string>
+
+namespace makeland {
+    using namespace std;
+
+    // SHA-1 (FIPS 180-4). Only used where the protocol requires it (WebSocket handshake),
+    // it must not be used for security purposes.
+    class SHA1 {
+    public:
+        static string digest(const string& data) {
+            uint32_t h[5] = { 0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0 };
+            string message = data;
+            uint64_t bitLength = (uint64_t)data.size() * 8;
+
+            message += (char)0x80;
+
+            while (message.size() % 64 != 56) {
+                message += (char)0x00;
+            }
+            for (int n = 7; n >= 0; n--) {
+                message += (char)((bitLength >> (n * 8)) & 0xFF);
+            }
+            for (size_t block = 0; block < message.size(); block += 64) {
+                processBlock((const uint8_t*)message.data() + block, h);
+            }
+            string ret(20, '\0');
+
+            for (size_t n = 0; n < 20; n++) {
+                ret[n] = (char)((h[n / 4] >> (24 - (n % 4) * 8)) & 0xFF);
+            }
+            return ret;
+        }
+
+    private:
+        static uint32_t rotateLeft(uint32_t value, int bits) {
+            return (value << bits) | (value >> (32 - bits));
+        }
+
+        static void processBlock(const uint8_t* block, uint32_t* h) {
+            uint32_t w[80];
+
+            for (int n = 0; n < 16; n++) {
+                w[n] = ((uint32_t)block[n * 4] << 24) | ((uint32_t)block[n * 4 + 1] << 16) | ((uint32_t)block[n * 4 + 2] << 8) | (uint32_t)block[n * 4 + 3];
+            }
+            for (int n = 16; n < 80; n++) {
+                w[n] = rotateLeft(w[n - 3] ^ w[n - 8] ^ w[n - 14] ^ w[n - 16], 1);
+            }
+            uint32_t a = h[0];
+            uint32_t b = h[1];
+            uint32_t c = h[2];
+            uint32_t d = h[3];
+            uint32_t e = h[4];
+
+            for (int n = 0; n < 80; n++) {
+                uint32_t f;
+                uint32_t k;
+
+                if (n < 20) {
+                    f = (b & c) | (~b & d);
+                    k = 0x5A827999;
+                }
+                else if (n < 40) {
+                    f = b ^ c ^ d;
+                    k = 0x6ED9EBA1;
+                }
+                else if (n < 60) {
+                    f = (b & c) | (b & d) | (c & d);
+                    k = 0x8F1BBCDC;
+                }
+                else {
+                    f = b ^ c ^ d;
+                    k = 0xCA62C1D6;
+                }
+                uint32_t temp = rotateLeft(a, 5) + f + e + k + w[n];
+                e = d;
+                d = c;
+                c = rotateLeft(b, 30);
+                b = a;
+                a = temp;
+            }
+            h[0] += a;
+            h[1] += b;
+            h[2] += c;
+            h[3] += d;
+            h[4] += e;
+        }
+    };
+}
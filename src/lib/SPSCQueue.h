@@ -0,0 +1,68 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+namespace makeland {
+    using namespace std;
+
+    // Bounded lock-free queue for exactly one producer thread and one consumer thread.
+    template<typename T>
+    class SPSCQueue {
+    public:
+        explicit SPSCQueue(size_t capacity) : slots(capacity + 1) {
+        }
+
+        SPSCQueue(const SPSCQueue&) = delete;
+        SPSCQueue& operator=(const SPSCQueue&) = delete;
+        SPSCQueue(const SPSCQueue&&) = delete;
+        SPSCQueue& operator=(const SPSCQueue&&) = delete;
+        ~SPSCQueue() = default;
+
+        // Producer side. Returns false if the queue is full.
+        bool push(T value) {
+            size_t tail = tailPos.load(memory_order_relaxed);
+            size_t next = increment(tail);
+
+            if (next == headPos.load(memory_order_acquire)) {
+                return false;
+            }
+            slots[tail] = move(value);
+            tailPos.store(next, memory_order_release);
+
+            return true;
+        }
+
+        // Consumer side. Returns false if the queue is empty.
+        bool pop(T& value) {
+            size_t head = headPos.load(memory_order_relaxed);
+
+            if (head == tailPos.load(memory_order_acquire)) {
+                return false;
+            }
+            value = move(slots[head]);
+            slots[head] = T();
+            headPos.store(increment(head), memory_order_release);
+
+            return true;
+        }
+
+        bool empty() const {
+            return headPos.load(memory_order_acquire) == tailPos.load(memory_order_acquire);
+        }
+
+    private:
+        vector<T> slots;
+        // Head and tail are written by different threads, keep them in different cache lines
+        atomic<size_t> headPos{ 0 };
+        char padding[64 - sizeof(atomic<size_t>)];
+        atomic<size_t> tailPos{ 0 };
+
+        size_t increment(size_t pos) const {
+            return (pos + 1) == slots.size() ? 0 : pos + 1;
+        }
+    };
+}
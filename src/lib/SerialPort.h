@@ -8,6 +8,7 @@
 #elif __linux__
 #include <unistd.h>
 #include <fcntl.h>
+#include <poll.h>
 #include <termios.h>
 #include <sys/ioctl.h>
 #include <linux/serial.h>
@@ -18,38 +19,11 @@
 #error Operating System not supported
 #endif
 
-#include "Result.h"
+#include "DateTime.h"
+#include "SerialTransport.h"
 
 namespace makeland {
-    enum class Parity {
-        None,
-        Odd,
-        Even,
-        Mark,
-        Space
-    };
-
-    enum class StopBits
-    {
-        One,
-        Two,
-        OnePointFive
-    };
-
-    enum class BaudRate
-    {
-        _1200,
-        _2400,
-        _4800,
-        _9600,
-        _19200,
-        _38400,
-        _57600,
-        _115200,
-        _230400
-    };
-
-    class SerialPort {
+    class SerialPort : public SerialTransport {
     public:
         SerialPort() = default;
         SerialPort(const SerialPort&) = delete;
@@ -58,14 +32,14 @@ namespace makeland {
         SerialPort& operator=(const SerialPort&&) = delete;
         ~SerialPort() = default;
 
-        bool isOpened() {
+        bool isOpened() override {
             if (handle == INVALID_HANDLE_VALUE) {
                 return false;
             }
             return true;
         }
 
-        Result open(string portName, BaudRate baudRate, Parity parity, int dataBits, StopBits stopBits) {
+        Result open(string portName, BaudRate baudRate, Parity parity, int dataBits, StopBits stopBits) override {
             if (isOpened()) {
                 return Result::ok();
             }
@@ -161,6 +135,17 @@ namespace makeland {
             if (!SetCommState(handle, &dcb)) {
                 return Result("serial_port_error", "Serial port error calling method `SetCommState`: {}", getLastError());
             }
+            // With both MAXDWORD, ReadFile returns as soon as a byte is received or after the constant
+            timeouts.ReadIntervalTimeout = MAXDWORD;
+            timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+            timeouts.ReadTotalTimeoutConstant = 1;
+            timeouts.WriteTotalTimeoutMultiplier = 0;
+            // 0 would never time out, `write` sets the remaining time before each WriteFile
+            timeouts.WriteTotalTimeoutConstant = 1;
+
+            if (!SetCommTimeouts(handle, &timeouts)) {
+                return Result("serial_port_error", "Serial port error calling method `SetCommTimeouts`: {}", getLastError());
+            }
 #elif __linux__
             struct termios settings;
             memset(&settings, 0, sizeof(settings));
@@ -194,7 +179,7 @@ namespace makeland {
                     break;
             };
 
-            speed_t baud;
+            speed_t baud = B115200;
 
             switch (baudRate) {
                 case BaudRate::_1200: baud = B1200;
@@ -217,11 +202,13 @@ namespace makeland {
                     break;
             }
 
+            // Reads and writes never block, `read` and `write` wait with `poll` until their deadline. With
+            // VMIN 1 a read without data fails with EAGAIN, so returning 0 means the device hung up.
             settings.c_lflag = 0;
             settings.c_cc[VMIN] = 1;
             settings.c_cc[VTIME] = 0;
 
-            handle = ::open(portName.data(), O_RDWR);
+            handle = ::open(portName.data(), O_RDWR | O_NOCTTY | O_NONBLOCK);
 
             if (handle == -1) {
                 return Result("serial_port_error", "Serial port error calling method `open`: {}", getLastError());
@@ -234,7 +221,7 @@ namespace makeland {
             return Result::ok();
         }
 
-        Result close() {
+        Result close() override {
             if (!isOpened()) {
                 return Result::ok();
             }
@@ -248,60 +235,172 @@ namespace makeland {
             return Result::ok();
         }
 
-        Result read(uint8_t* buffer, size_t size, size_t* totalRead) {
+        // Reads exactly `size` bytes. Deadlines are absolute `DateTime::monotonicMilliseconds` values.
+        // On timeout the result code is `serial_port_timeout` and `totalRead` has the bytes received so far.
+        Result read(uint8_t* buffer, size_t size, uint64_t deadline, size_t* totalRead) override {
+            return receive(buffer, size, size, deadline, totalRead);
+        }
+
+        // Reads up to `size` bytes, waiting until at least one is received. A past deadline only returns
+        // what has already been received.
+        Result readSome(uint8_t* buffer, size_t size, uint64_t deadline, size_t* totalRead) override {
+            return receive(buffer, size, 1, deadline, totalRead);
+        }
+
+        // Discards everything received and not read yet
+        Result purge() override {
             if (!isOpened()) {
                 return Result("serial_port_not_opened", "Serial port is not Opened");
             }
 #ifdef _WIN32
-            DWORD numberOfBytesRead;
-
-            if (!ReadFile(handle, buffer, (DWORD)size, &numberOfBytesRead, NULL)) {
-                return Result("serial_port_error", "Serial port error calling method `ReadFile`: {}", getLastError());
-            }
-            if (totalRead) {
-                *totalRead = numberOfBytesRead;
+            if (PurgeComm(handle, PURGE_RXABORT | PURGE_RXCLEAR) == 0) {
+                return Result("serial_port_error", "Serial port error calling method `PurgeComm`: {}", getLastError());
             }
 #elif __linux__
-            int count = ::read(handle, (void*)buffer, size);
-
-            if (count == -1) {
-                return Result("serial_port_error", "Serial port error calling method `read`: {}", getLastError());
-            }
-            if (totalRead) {
-                *totalRead = (size_t)count;
+            if (tcflush(handle, TCIFLUSH) == -1) {
+                return Result("serial_port_error", "Serial port error calling method `tcflush`: {}", getLastError());
             }
 #endif
             return Result::ok();
         }
 
-        Result write(uint8_t* buffer, size_t size) {
+        // Writes `size` bytes, the result code is `serial_port_timeout` if `deadline` is reached first
+        Result write(const uint8_t* buffer, size_t size, uint64_t deadline) override {
             if (!isOpened()) {
                 return Result("serial_port_not_opened", "Serial port is not Opened");
             }
+            size_t totalWritten = 0;
+
+            while (true) {
 #ifdef _WIN32
-            DWORD written;
+                DWORD written;
+                Result result = setTimeouts(0, remaining(deadline));
+
+                if (result) {
+                    return result;
+                }
+                if (!WriteFile(handle, buffer + totalWritten, (DWORD)(size - totalWritten), &written, NULL)) {
+                    return Result("serial_port_error", "Serial port error calling method `WriteFile`: {}", getLastError());
+                }
+                totalWritten += written;
+#elif __linux__
+                ssize_t count = ::write(handle, (const void*)(buffer + totalWritten), size - totalWritten);
 
-            if (!WriteFile(handle, buffer, (DWORD)size, &written, NULL)) {
-                return Result("serial_port_error", "Serial port error calling method `WriteFile`: {}", getLastError());
+                if (count == -1 && errno != EAGAIN && errno != EINTR) {
+                    return Result("serial_port_error", "Serial port error calling method `write`: {}", getLastError());
+                }
+                totalWritten += count > 0 ? (size_t)count : 0;
+#endif
+                if (totalWritten == size) {
+                    return Result::ok();
+                }
+                if (DateTime::monotonicMilliseconds() >= deadline) {
+                    return Result("serial_port_timeout", "Timeout writing serial port ({} of {} bytes written)", totalWritten, size);
+                }
+#ifdef __linux__
+                Result result = waitReady(POLLOUT, deadline);
+
+                if (result) {
+                    return result;
+                }
+#endif
             }
-            if (written != size) {
-                return Result("not_written", "Not all data written in com port");
+        }
+
+    private:
+        HANDLE handle = INVALID_HANDLE_VALUE;
+#ifdef _WIN32
+        COMMTIMEOUTS timeouts;
+#endif
+
+        Result receive(uint8_t* buffer, size_t size, size_t minSize, uint64_t deadline, size_t* totalRead) {
+            *totalRead = 0;
+
+            if (!isOpened()) {
+                return Result("serial_port_not_opened", "Serial port is not Opened");
             }
+            while (true) {
+#ifdef _WIN32
+                // Returns as soon as one byte is received, or after the read timeout
+                DWORD count;
+                Result result = setTimeouts(remaining(deadline), 0);
+
+                if (result) {
+                    return result;
+                }
+                if (!ReadFile(handle, buffer + *totalRead, (DWORD)(size - *totalRead), &count, NULL)) {
+                    return Result("serial_port_error", "Serial port error calling method `ReadFile`: {}", getLastError());
+                }
+                *totalRead += count;
 #elif __linux__
-            int count = ::write(handle, (void*)buffer, size);
+                ssize_t count = ::read(handle, (void*)(buffer + *totalRead), size - *totalRead);
+
+                if (count == -1 && errno != EAGAIN && errno != EINTR) {
+                    return Result("serial_port_error", "Serial port error calling method `read`: {}", getLastError());
+                }
+                if (count == 0) {
+                    return Result("serial_port_error", "Serial port closed ({} of {} bytes received)", *totalRead, minSize);
+                }
+                *totalRead += count > 0 ? (size_t)count : 0;
+#endif
+                if (*totalRead >= minSize) {
+                    return Result::ok();
+                }
+                if (DateTime::monotonicMilliseconds() >= deadline) {
+                    return Result("serial_port_timeout", "Timeout reading serial port ({} of {} bytes received)", *totalRead, minSize);
+                }
+#ifdef __linux__
+                Result result = waitReady(POLLIN, deadline);
+
+                if (result) {
+                    return result;
+                }
+#endif
+            }
+        }
+
+        static uint64_t remaining(uint64_t deadline) {
+            uint64_t now = DateTime::monotonicMilliseconds();
+
+            return deadline > now ? deadline - now : 0;
+        }
+
+#ifdef _WIN32
+        // Timeouts in milliseconds, only changed when needed. At least 1, since 0 disables the write timeout
+        // and the loops check their own deadline anyway.
+        Result setTimeouts(uint64_t readTimeout, uint64_t writeTimeout) {
+            DWORD readConstant = (DWORD)max<uint64_t>(1, min<uint64_t>(readTimeout, MAXDWORD - 1));
+            DWORD writeConstant = (DWORD)max<uint64_t>(1, min<uint64_t>(writeTimeout, MAXDWORD - 1));
 
-            if (count == -1) {
-                return Result("serial_port_error", "Serial port error calling method `write`: {}", getLastError());
+            if (timeouts.ReadTotalTimeoutConstant == readConstant && timeouts.WriteTotalTimeoutConstant == writeConstant) {
+                return Result::ok();
             }
-            if ((size_t)count != size) {
-                return Result("not_written", "Not all data written in com port");
+            timeouts.ReadTotalTimeoutConstant = readConstant;
+            timeouts.WriteTotalTimeoutConstant = writeConstant;
+
+            if (!SetCommTimeouts(handle, &timeouts)) {
+                return Result("serial_port_error", "Serial port error calling method `SetCommTimeouts`: {}", getLastError());
             }
-#endif
             return Result::ok();
         }
-
-    private:
-        HANDLE handle = INVALID_HANDLE_VALUE;
+#elif __linux__
+        // Waits until `events` are ready or `deadline` is reached, the caller checks which one happened.
+        // A hung up or failed device is an error, otherwise poll would return at once until the deadline.
+        Result waitReady(short events, uint64_t deadline) {
+            struct pollfd descriptor;
+            descriptor.fd = handle;
+            descriptor.events = events;
+            descriptor.revents = 0;
+
+            if (::poll(&descriptor, 1, (int)min<uint64_t>(remaining(deadline), INT32_MAX)) == -1 && errno != EINTR) {
+                return Result("serial_port_error", "Serial port error calling method `poll`: {}", getLastError());
+            }
+            if ((descriptor.revents & (POLLHUP | POLLERR | POLLNVAL)) != 0) {
+                return Result("serial_port_error", "Serial port closed or failed (revents={})", descriptor.revents);
+            }
+            return Result::ok();
+        }
+#endif
 
         string getLastError() {
 #ifdef _WIN32
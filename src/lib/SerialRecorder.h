@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <stdio.h>
+#include <memory>
+
+#include "DateTime.h"
+#include "SerialTransport.h"
+
+// Trace file: magic and version, then one record per operation, in order:
+//   type (1 byte), microseconds since the previous record (LEB128),
+//   for writes and reads: size (LEB128) and the bytes.
+// Reads record only the bytes actually received, a read that received nothing has no record.
+#define SERIAL_TRACE_MAGIC    "SERTRACE"
+#define SERIAL_TRACE_VERSION  1
+
+#define SERIAL_TRACE_WRITE    0x01
+#define SERIAL_TRACE_READ     0x02
+#define SERIAL_TRACE_PURGE    0x03
+
+namespace makeland {
+    // Forwards every operation to another transport and records it, with timestamps, into a trace
+    // file that SerialReplay plays back
+    class SerialRecorder : public SerialTransport {
+    public:
+        // 1. Lifecycle
+        SerialRecorder() = default;
+        SerialRecorder(const SerialRecorder&) = delete;
+        SerialRecorder& operator=(const SerialRecorder&) = delete;
+        SerialRecorder(const SerialRecorder&&) = delete;
+        SerialRecorder& operator=(const SerialRecorder&&) = delete;
+        ~SerialRecorder() {
+            close();
+        }
+
+        // 2. Dependency injection
+        void setFileName(const string& _fileName) {
+            fileName = _fileName;
+        }
+
+        void setTransport(unique_ptr<SerialTransport> _transport) {
+            transport = move(_transport);
+        }
+
+        // 3. Functionalities
+        bool isOpened() override {
+            return transport->isOpened();
+        }
+
+        Result open(string portName, BaudRate baudRate, Parity parity, int dataBits, StopBits stopBits) override {
+            if (file == nullptr) {
+                file = fopen(fileName.data(), "wb");
+
+                if (file == nullptr) {
+                    return Result("serial_recorder_error", "Error creating trace file `{}`: errno={} ({})", fileName, errno, strerror(errno));
+                }
+                lastTime = DateTime::monotonicMicroseconds();
+
+                uint8_t version = SERIAL_TRACE_VERSION;
+
+                if (fwrite(SERIAL_TRACE_MAGIC, 1, strlen(SERIAL_TRACE_MAGIC), file) != strlen(SERIAL_TRACE_MAGIC) || fwrite(&version, 1, 1, file) != 1) {
+                    return writeError();
+                }
+            }
+            return transport->open(portName, baudRate, parity, dataBits, stopBits);
+        }
+
+        Result close() override {
+            if (file != nullptr) {
+                fclose(file);
+                file = nullptr;
+            }
+            return transport ? transport->close() : Result::ok();
+        }
+
+        Result read(uint8_t* buffer, size_t size, uint64_t deadline, size_t* totalRead) override {
+            Result result = transport->read(buffer, size, deadline, totalRead);
+
+            return recordRead(result, buffer, *totalRead);
+        }
+
+        Result readSome(uint8_t* buffer, size_t size, uint64_t deadline, size_t* totalRead) override {
+            Result result = transport->readSome(buffer, size, deadline, totalRead);
+
+            return recordRead(result, buffer, *totalRead);
+        }
+
+        Result purge() override {
+            Result result = record(SERIAL_TRACE_PURGE, nullptr, 0);
+
+            if (result) {
+                return result;
+            }
+            return transport->purge();
+        }
+
+        // Commands are flushed to the file right away, so a trace ends at the last command sent
+        // even if the process is killed
+        Result write(const uint8_t* buffer, size_t size, uint64_t deadline) override {
+            Result result = record(SERIAL_TRACE_WRITE, buffer, size);
+
+            if (result) {
+                return result;
+            }
+            if (fflush(file) != 0) {
+                return writeError();
+            }
+            return transport->write(buffer, size, deadline);
+        }
+
+    private:
+        string fileName;
+        unique_ptr<SerialTransport> transport;
+        FILE* file = nullptr;
+        uint64_t lastTime = 0;
+
+        Result recordRead(const Result& result, const uint8_t* buffer, size_t totalRead) {
+            if (totalRead > 0) {
+                Result recordResult = record(SERIAL_TRACE_READ, buffer, totalRead);
+
+                if (recordResult) {
+                    return recordResult;
+                }
+            }
+            return result;
+        }
+
+        Result record(uint8_t type, const uint8_t* buffer, size_t size) {
+            if (file == nullptr) {
+                return Result("serial_port_not_opened", "Serial port is not Opened");
+            }
+            uint64_t now = DateTime::monotonicMicroseconds();
+            uint8_t header[1 + 10 + 10];
+            size_t headerSize = 0;
+
+            header[headerSize++] = type;
+            headerSize += encodeVarint(now - lastTime, header + headerSize);
+
+            if (type != SERIAL_TRACE_PURGE) {
+                headerSize += encodeVarint(size, header + headerSize);
+            }
+            lastTime = now;
+
+            if (fwrite(header, 1, headerSize, file) != headerSize || (size > 0 && fwrite(buffer, 1, size, file) != size)) {
+                return writeError();
+            }
+            return Result::ok();
+        }
+
+        Result writeError() {
+            return Result("serial_recorder_error", "Error writing trace file `{}`: errno={} ({})", fileName, errno, strerror(errno));
+        }
+
+        // LEB128, 7 bits per byte, least significant first
+        static size_t encodeVarint(uint64_t value, uint8_t* buffer) {
+            size_t size = 0;
+
+            while (value >= 0x80) {
+                buffer[size++] = (uint8_t)(value | 0x80);
+                value >>= 7;
+            }
+            buffer[size++] = (uint8_t)value;
+
+            return size;
+        }
+    };
+}
@@ -0,0 +1,269 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include <thread>
+
+#include "SerialRecorder.h"
+
+namespace makeland {
+    enum class ReplaySpeed {
+        // Received bytes are delayed as in the trace, relative to the write or purge before them
+        Original,
+        // Received bytes are available at once, missing ones time out without waiting
+        Fast
+    };
+
+    // Plays back a SerialRecorder trace in place of a serial port. Writes must match the recorded
+    // bytes, then the bytes recorded as received after them are delivered with the same read sizes,
+    // so the reader goes through the same states as in the recorded session. A purge (the start of a
+    // sweep) moves to the next recorded purge, and at the end of the trace back to the first one, so
+    // recorded sweeps can be replayed again and again.
+    class SerialReplay : public SerialTransport {
+    public:
+        // 1. Lifecycle
+        SerialReplay() = default;
+        SerialReplay(const SerialReplay&) = delete;
+        SerialReplay& operator=(const SerialReplay&) = delete;
+        SerialReplay(const SerialReplay&&) = delete;
+        SerialReplay& operator=(const SerialReplay&&) = delete;
+        ~SerialReplay() = default;
+
+        // 2. Dependency injection
+        void setFileName(const string& _fileName) {
+            fileName = _fileName;
+        }
+
+        void setSpeed(ReplaySpeed _speed) {
+            speed = _speed;
+        }
+
+        // 3. Functionalities
+        bool isOpened() override {
+            return opened;
+        }
+
+        // Loads the whole trace, the port settings are ignored
+        Result open(string portName, BaudRate baudRate, Parity parity, int dataBits, StopBits stopBits) override {
+            if (opened) {
+                return Result::ok();
+            }
+            Result result = load();
+
+            if (result) {
+                return result;
+            }
+            next = 0;
+            position = 0;
+            anchor = DateTime::monotonicMicroseconds();
+            opened = true;
+
+            return Result::ok();
+        }
+
+        Result close() override {
+            opened = false;
+            records.clear();
+            data.clear();
+
+            return Result::ok();
+        }
+
+        Result read(uint8_t* buffer, size_t size, uint64_t deadline, size_t* totalRead) override {
+            return receive(buffer, size, size, deadline, totalRead);
+        }
+
+        Result readSome(uint8_t* buffer, size_t size, uint64_t deadline, size_t* totalRead) override {
+            return receive(buffer, size, 1, deadline, totalRead);
+        }
+
+        Result purge() override {
+            if (!opened) {
+                return Result("serial_port_not_opened", "Serial port is not Opened");
+            }
+            // Skips what is left of a sweep that diverged from the trace
+            while (next < records.size() && records[next].type != SERIAL_TRACE_PURGE) {
+                next++;
+            }
+            if (next == records.size()) {
+                next = loopRecord;
+            }
+            if (next == records.size()) {
+                return Result("serial_replay_error", "Trace `{}` has no sweep to replay", fileName);
+            }
+            consumed(records[next]);
+
+            return Result::ok();
+        }
+
+        Result write(const uint8_t* buffer, size_t size, uint64_t deadline) override {
+            if (!opened) {
+                return Result("serial_port_not_opened", "Serial port is not Opened");
+            }
+            size_t totalWritten = 0;
+
+            while (totalWritten < size) {
+                if (next == records.size() || records[next].type != SERIAL_TRACE_WRITE) {
+                    return Result("serial_replay_error", "Write of {} bytes does not follow trace `{}` at record {}", size, fileName, next);
+                }
+                const Record& record = records[next];
+                size_t count = min(size - totalWritten, record.size - position);
+
+                if (memcmp(buffer + totalWritten, data.data() + record.offset + position, count) != 0) {
+                    return Result("serial_replay_error", "Written bytes differ from trace `{}` at record {}", fileName, next);
+                }
+                totalWritten += count;
+                position += count;
+
+                if (position == record.size) {
+                    consumed(record);
+                }
+            }
+            return Result::ok();
+        }
+
+    private:
+        struct Record {
+            uint8_t type;
+            uint64_t time;  // Microseconds since the start of the trace
+            size_t offset;  // Bytes in `data`
+            size_t size;
+        };
+
+        string fileName;
+        ReplaySpeed speed = ReplaySpeed::Original;
+        bool opened = false;
+        vector<uint8_t> data;
+        vector<Record> records;
+        size_t loopRecord = 0;
+
+        size_t next = 0;      // Next record to replay
+        size_t position = 0;  // Bytes of `next` already written or read
+        uint64_t anchor = 0;  // Monotonic microseconds matching time 0 of the trace
+
+        Result receive(uint8_t* buffer, size_t size, size_t minSize, uint64_t deadline, size_t* totalRead) {
+            *totalRead = 0;
+
+            if (!opened) {
+                return Result("serial_port_not_opened", "Serial port is not Opened");
+            }
+            while (next < records.size() && records[next].type == SERIAL_TRACE_READ) {
+                const Record& record = records[next];
+
+                // Waits for the record even past the deadline: it was received in the recorded
+                // session, a read returning less would change the reader's behavior
+                if (speed == ReplaySpeed::Original) {
+                    uint64_t release = anchor + record.time;
+                    uint64_t now = DateTime::monotonicMicroseconds();
+
+                    if (release > now) {
+                        this_thread::sleep_for(chrono::microseconds(release - now));
+                    }
+                }
+                size_t count = min(size - *totalRead, record.size - position);
+
+                memcpy(buffer + *totalRead, data.data() + record.offset + position, count);
+                *totalRead += count;
+                position += count;
+
+                if (position == record.size) {
+                    next++;
+                    position = 0;
+                }
+                // One record per call at most, as it was received
+                if (*totalRead >= minSize) {
+                    return Result::ok();
+                }
+            }
+            // Nothing else is received before the next write, or before the deadline
+            if (speed == ReplaySpeed::Original) {
+                uint64_t now = DateTime::monotonicMilliseconds();
+
+                if (deadline > now) {
+                    this_thread::sleep_for(chrono::milliseconds(deadline - now));
+                }
+            }
+            return Result("serial_port_timeout", "Timeout reading serial port ({} of {} bytes received)", *totalRead, minSize);
+        }
+
+        // Times of the records received next are relative to the last write or purge
+        void consumed(const Record& record) {
+            anchor = DateTime::monotonicMicroseconds() - record.time;
+            next++;
+            position = 0;
+        }
+
+        Result load() {
+            FILE* file = fopen(fileName.data(), "rb");
+
+            if (file == nullptr) {
+                return Result("serial_replay_error", "Error opening trace file `{}`: errno={} ({})", fileName, errno, strerror(errno));
+            }
+            uint8_t buffer[64 * 1024];
+            size_t count;
+
+            data.clear();
+
+            while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+                data.insert(data.end(), buffer, buffer + count);
+            }
+            fclose(file);
+
+            size_t magicSize = strlen(SERIAL_TRACE_MAGIC);
+
+            if (data.size() < magicSize + 1 || memcmp(data.data(), SERIAL_TRACE_MAGIC, magicSize) != 0 || data[magicSize] != SERIAL_TRACE_VERSION) {
+                return Result("serial_replay_error", "File `{}` is not a serial trace (version {})", fileName, SERIAL_TRACE_VERSION);
+            }
+            size_t offset = magicSize + 1;
+            uint64_t time = 0;
+
+            records.clear();
+            loopRecord = SIZE_MAX;
+
+            while (offset < data.size()) {
+                Record record;
+                uint64_t delta;
+                uint64_t size = 0;
+
+                record.type = data[offset++];
+
+                bool valid = (record.type == SERIAL_TRACE_WRITE || record.type == SERIAL_TRACE_READ || record.type == SERIAL_TRACE_PURGE) &&
+                    decodeVarint(offset, delta) && (record.type == SERIAL_TRACE_PURGE || decodeVarint(offset, size)) &&
+                    size <= data.size() - offset;
+
+                if (!valid) {
+                    return Result("serial_replay_error", "Trace file `{}` is corrupted at record {}", fileName, records.size());
+                }
+                time += delta;
+                record.time = time;
+                record.offset = offset;
+                record.size = (size_t)size;
+                offset += record.size;
+
+                if (record.type == SERIAL_TRACE_PURGE && loopRecord == SIZE_MAX) {
+                    loopRecord = records.size();
+                }
+                records.push_back(record);
+            }
+            if (loopRecord == SIZE_MAX) {
+                loopRecord = records.size();
+            }
+            return Result::ok();
+        }
+
+        bool decodeVarint(size_t& offset, uint64_t& value) {
+            value = 0;
+
+            for (size_t shift = 0; shift < 64 && offset < data.size(); shift += 7) {
+                uint8_t byte = data[offset++];
+                value |= (uint64_t)(byte & 0x7F) << shift;
+
+                if ((byte & 0x80) == 0) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+}
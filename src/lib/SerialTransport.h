@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include "Result.h"
+
+namespace makeland {
+    enum class Parity {
+        None,
+        Odd,
+        Even,
+        Mark,
+        Space
+    };
+
+    enum class StopBits
+    {
+        One,
+        Two,
+        OnePointFive
+    };
+
+    enum class BaudRate
+    {
+        _1200,
+        _2400,
+        _4800,
+        _9600,
+        _19200,
+        _38400,
+        _57600,
+        _115200,
+        _230400
+    };
+
+    // Bytes exchanged with a serial device: a real port (SerialPort), a recorder of another transport
+    // (SerialRecorder) or the replay of a recorded trace (SerialReplay).
+    // Deadlines are absolute `DateTime::monotonicMilliseconds` values. On timeout the result code is
+    // `serial_port_timeout`.
+    class SerialTransport {
+    public:
+        virtual ~SerialTransport() = default;
+
+        virtual bool isOpened() = 0;
+
+        virtual Result open(string portName, BaudRate baudRate, Parity parity, int dataBits, StopBits stopBits) = 0;
+
+        virtual Result close() = 0;
+
+        // Reads exactly `size` bytes, `totalRead` has the bytes received even on timeout
+        virtual Result read(uint8_t* buffer, size_t size, uint64_t deadline, size_t* totalRead) = 0;
+
+        // Reads up to `size` bytes, waiting until at least one is received
+        virtual Result readSome(uint8_t* buffer, size_t size, uint64_t deadline, size_t* totalRead) = 0;
+
+        // Discards everything received and not read yet
+        virtual Result purge() = 0;
+
+        virtual Result write(const uint8_t* buffer, size_t size, uint64_t deadline) = 0;
+    };
+}
@@ -560,7 +560,7 @@ namespace makeland {
                 else if (events[i].events & EPOLLIN) {
                     if (events[i].data.fd == eventFd) {
                         uint64_t v;
-                        int count = recv(events[i].data.fd, &v, sizeof(v), 0);
+                        ssize_t count = ::read(events[i].data.fd, &v, sizeof(v));
 
                         if (count == -1) {
                             return Result("socket_error", "`read()` method error: {}", getOSLastError());
@@ -657,10 +657,10 @@ namespace makeland {
             lock_guard<mutex> guard(epollFdMutex);
 
             ssize_t ret = 0;
-            uint64_t val = 0;
+            uint64_t val = 1;
 
             do {
-                ret = ::write(epollFd, &val, sizeof(val));
+                ret = ::write(eventFd, &val, sizeof(val));
             } while (ret < 0 && errno == EAGAIN);
 #endif
         }
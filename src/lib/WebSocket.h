@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#pragma once
+
+#include "Result.h"
+#include "SHA1.h"
+#include "StringUtils.h"
+
+#define WEBSOCKET_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+#define WEBSOCKET_OPCODE_CONTINUATION 0x0
+#define WEBSOCKET_OPCODE_TEXT         0x1
+#define WEBSOCKET_OPCODE_BINARY       0x2
+#define WEBSOCKET_OPCODE_CLOSE        0x8
+#define WEBSOCKET_OPCODE_PING         0x9
+#define WEBSOCKET_OPCODE_PONG         0xA
+
+#define WEBSOCKET_CLOSE_NORMAL        1000
+#define WEBSOCKET_CLOSE_PROTOCOL      1002
+#define WEBSOCKET_CLOSE_TOO_BIG       1009
+
+#define WEBSOCKET_MAX_CONTROL_PAYLOAD 125
+
+namespace makeland {
+    using namespace std;
+
+    struct WebSocketFrame {
+        bool fin = false;
+        uint8_t opcode = 0;
+        string payload;
+    };
+
+    // WebSocket (RFC 6455) handshake and framing, server side
+    class WebSocket {
+    public:
+        // Value of the `Sec-WebSocket-Accept` header for the client `Sec-WebSocket-Key`
+        static string acceptKey(const string& key) {
+            string digest = SHA1::digest(key + WEBSOCKET_GUID);
+            string accept = su::encodeBase64url(StringShadow(digest.data(), 0, digest.size()));
+
+            for (char& c : accept) {
+                if (c == '-') {
+                    c = '+';
+                }
+                else if (c == '_') {
+                    c = '/';
+                }
+            }
+            return accept;
+        }
+
+        // Parses one client frame from the start of `buffer`. Returns the number of bytes used in
+        // `consumed`, or 0 if the frame is still incomplete.
+        static Result decodeFrame(const string& buffer, size_t maxPayload, WebSocketFrame& frame, size_t* consumed) {
+            const uint8_t* data = (const uint8_t*)buffer.data();
+            size_t size = buffer.size();
+            *consumed = 0;
+
+            if (size < 2) {
+                return Result::ok();
+            }
+            frame.fin = (data[0] & 0x80) != 0;
+            frame.opcode = data[0] & 0x0F;
+
+            if ((data[0] & 0x70) != 0) {
+                return Result("websocket_error", "Reserved bits set");
+            }
+            if ((data[1] & 0x80) == 0) {
+                return Result("websocket_error", "Client frames must be masked");
+            }
+            uint64_t length = data[1] & 0x7F;
+            size_t pos = 2;
+
+            if (length == 126) {
+                if (size < pos + 2) {
+                    return Result::ok();
+                }
+                length = ((uint64_t)data[2] << 8) | data[3];
+                pos += 2;
+            }
+            else if (length == 127) {
+                if (size < pos + 8) {
+                    return Result::ok();
+                }
+                length = 0;
+
+                for (size_t n = 0; n < 8; n++) {
+                    length = (length << 8) | data[2 + n];
+                }
+                pos += 8;
+            }
+            // Control frames (close, ping, pong) are never fragmented and fit in one byte length (RFC 6455 5.5)
+            if ((frame.opcode & 0x08) != 0 && (!frame.fin || length > WEBSOCKET_MAX_CONTROL_PAYLOAD)) {
+                return Result("websocket_error", "Fragmented or too long control frame");
+            }
+            if (length > maxPayload) {
+                return Result("websocket_too_big", "Frame payload too big ({} bytes)", length);
+            }
+            if (size < pos + 4 + length) {
+                return Result::ok();
+            }
+            const uint8_t* mask = data + pos;
+            pos += 4;
+
+            frame.payload.resize((size_t)length);
+
+            for (size_t n = 0; n < length; n++) {
+                frame.payload[n] = (char)(data[pos + n] ^ mask[n % 4]);
+            }
+            *consumed = pos + (size_t)length;
+
+            return Result::ok();
+        }
+
+        // Server frames are never masked nor fragmented
+        static string encodeFrameHeader(uint8_t opcode, size_t size) {
+            string header;
+            header += (char)(0x80 | opcode);
+
+            if (size < 126) {
+                header += (char)size;
+            }
+            else if (size <= 0xFFFF) {
+                header += (char)126;
+                header += (char)((size >> 8) & 0xFF);
+                header += (char)(size & 0xFF);
+            }
+            else {
+                header += (char)127;
+
+                for (int n = 7; n >= 0; n--) {
+                    header += (char)(((uint64_t)size >> (n * 8)) & 0xFF);
+                }
+            }
+            return header;
+        }
+
+        static string encodeFrame(uint8_t opcode, const string& payload) {
+            return encodeFrameHeader(opcode, payload.size()) + payload;
+        }
+
+        static string encodeClose(uint16_t code) {
+            string payload;
+            payload += (char)(code >> 8);
+            payload += (char)(code & 0xFF);
+
+            return encodeFrame(WEBSOCKET_OPCODE_CLOSE, payload);
+        }
+    };
+}
@@ -10,6 +10,13 @@
 #include "LoggerLiteVNAServer.h" 
 #include "Config.h"
 #include "LiteVNA.h"
+#include "ScanMetrics.h"
+#include "Calibration.h"
+#include "TDR.h"
+#include "SweepService.h"
+#include "DevicePool.h"
+#include "SweepCache.h"
+#include "SweepEncoder.h"
 #include "HTTPServer.h"
 
 using namespace litevnaserver;
@@ -19,10 +26,14 @@ class Main {
 public:
     int execute(int argc, char* argv[]) {
         // Dependency injection
-        litevna->setConfig(config.get());
+        devicePool->setConfig(config.get());
+        sweepCache->setConfig(config.get());
+        calibration->setConfig(config.get());
 
         httpServer->setConfig(config.get());
-        httpServer->setLiteVNA(litevna.get());
+        httpServer->setDevicePool(devicePool.get());
+        httpServer->setSweepCache(sweepCache.get());
+        httpServer->setCalibration(calibration.get());
 
         // Initialization
         LoggerLiteVNAServer::initialize();
@@ -43,7 +54,15 @@ public:
         }
         LOGGER(Info, "litevna2json version: {}", config->version);
 
-        result = litevna->initialize();
+        result = calibration->initialize();
+
+        if (result) {
+            LOGGER(Error, result.toLog());
+            terminate();
+
+            return -1;
+        }
+        result = devicePool->initialize();
 
         if (result) {
             LOGGER(Error, result.toLog());
@@ -77,7 +96,7 @@ public:
     }
 
     void terminate() {
-        litevna->terminate();
+        devicePool->terminate();
         httpServer->terminate();
     }
 
@@ -85,7 +104,9 @@ private:
     unique_ptr<Logger> loggerConsole = make_unique<LoggerConsole>();
     unique_ptr<LoggerFile> loggerFile = make_unique<LoggerFile>();
     unique_ptr<Config> config = make_unique<Config>();
-    unique_ptr<LiteVNA> litevna = make_unique<LiteVNA>();
+    unique_ptr<DevicePool> devicePool = make_unique<DevicePool>();
+    unique_ptr<SweepCache> sweepCache = make_unique<SweepCache>();
+    unique_ptr<Calibration> calibration = make_unique<Calibration>();
     unique_ptr<HTTPServer> httpServer = make_unique<HTTPServer>();
 };
 
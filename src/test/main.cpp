@@ -0,0 +1,79 @@
+// SPDX-License-Identifier: GPL-2.0-only
+// Copyright (c) 2025 Julio Cesar Ziviani Alvarez
+
+#include <stdint.h>
+#include <memory>
+
+#include "lib/LoggerConsole.h"
+
+#include "LoggerLiteVNAServer.h"
+#include "Config.h"
+#include "LiteVNA.h"
+#include "ScanMetrics.h"
+#include "Calibration.h"
+#include "TDR.h"
+#include "SweepService.h"
+#include "SweepEncoder.h"
+
+using namespace litevnaserver;
+using namespace makeland;
+
+// Checks of the encoders that the emulator cannot reach, `make test` builds and runs them
+class Main {
+public:
+    int execute() {
+        testInt16ScaleIgnoresInfinity();
+
+        printf("%d checks, %d failed\n", checks, failures);
+
+        return failures == 0 ? 0 : -1;
+    }
+
+private:
+    int checks = 0;
+    int failures = 0;
+
+    void check(bool condition, const char* description) {
+        checks++;
+
+        if (!condition) {
+            failures++;
+            printf("FAILED: %s\n", description);
+        }
+    }
+
+    // A zero reference divides to an infinite value, the finite ones must keep the resolution of the scale
+    void testInt16ScaleIgnoresInfinity() {
+        SweepJob job;
+        job.spec.start = 1000000;
+        job.spec.step = 1000000;
+        job.spec.points = 2;
+        job.values.channel0In = { complex<float>(INFINITY, 0.5f), complex<float>(-0.25f, 0.125f) };
+        job.values.channel1In = { complex<float>(0.0f, 0.0f), complex<float>(0.5f, -0.5f) };
+
+        string out;
+        BinaryEncoder encoder(SampleFormat::Int16);
+        encoder.encode(out, job, false);
+
+        float scale = 0.0f;
+        int16_t samples[8];
+
+        check(out.size() == SWEEP_ENCODER_BINARY_HEADER_SIZE + sizeof(scale) + sizeof(samples), "int16 sweep size");
+
+        if (out.size() != SWEEP_ENCODER_BINARY_HEADER_SIZE + sizeof(scale) + sizeof(samples)) {
+            return;
+        }
+        memcpy(&scale, out.data() + SWEEP_ENCODER_BINARY_HEADER_SIZE, sizeof(scale));
+        memcpy(samples, out.data() + SWEEP_ENCODER_BINARY_HEADER_SIZE + sizeof(scale), sizeof(samples));
+
+        check(scale == 0.5f / 32767.0f, "int16 scale from the largest finite value");
+        check(samples[0] == 32767, "int16 infinity clamped");
+        check(samples[1] == 32767, "int16 largest finite value");
+        check(samples[2] == -16384 && samples[3] == 8192, "int16 finite values keep their resolution");
+        check(samples[6] == 32767 && samples[7] == -32767, "int16 second channel with the same scale");
+    }
+};
+
+int main() {
+    return Main().execute();
+}